@@ -0,0 +1,194 @@
+/*	Plays games with the engine alone and reports how fast it searches.
+ *
+ *		tetris_bench [--games n] [--pieces n] [--seed n] [--budget ms] [--lookahead n]
+ *			[--beam width] [--beam-depth n] [--threads n]
+ *			[--rollouts n] [--rollout-pieces n] [--mcts simulations] [--buffer rows]
+ *
+ *	Duplicates are placements the search skipped because another one at the
+ *	same depth had left the same board, which takes a --lookahead of 2 or a
+ *	beam. With --beam the moves come from a BeamSearch, which also reports
+ *	how many of the boards it scored were pruned from the beam. With --rollouts the
+ *	leaves of the search are scored by playing on from them, --threads then
+ *	sets how many threads run the playouts. --mcts plays with a MctsSearch
+ *	that keeps its tree from move to move, 0 simulations leaves it to --budget.
+ *	Otherwise one Solver plays every move, and reused counts the placement
+ *	lists and leaf values it carried over instead of working them out again.
+ *
+ *	The piece sequence only depends on the seed, so two builds given the same
+ *	arguments play the same games as long as they pick the same moves.
+ */
+
+#include "Engine.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+
+int main(int argc, char *argv[])
+{
+	int games = 5;
+	int max_pieces = 500;
+	unsigned int seed = 1;
+	int lookahead = 1;
+	int buffer_rows = 0;
+	SearchOptions options;
+	BeamOptions beam_options;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		std::string arg = argv[i];
+		if (arg == "--games")
+		{
+			games = std::atoi(argv[i + 1]);
+		}
+		else if (arg == "--pieces")
+		{
+			max_pieces = std::atoi(argv[i + 1]);
+		}
+		else if (arg == "--seed")
+		{
+			seed = static_cast<unsigned int>(std::strtoul(argv[i + 1], nullptr, 10));
+		}
+		else if (arg == "--budget")
+		{
+			options.time_budget_ms = std::atoi(argv[i + 1]);
+		}
+		else if (arg == "--buffer")
+		{
+			buffer_rows = std::atoi(argv[i + 1]);
+		}
+		else if (arg == "--lookahead")
+		{
+			lookahead = std::atoi(argv[i + 1]);
+		}
+		else if (arg == "--beam")
+		{
+			options.beam_width = std::atoi(argv[i + 1]);
+		}
+		else if (arg == "--beam-depth")
+		{
+			beam_options.depth = std::atoi(argv[i + 1]);
+		}
+		else if (arg == "--threads")
+		{
+			beam_options.threads = std::atoi(argv[i + 1]);
+			options.rollout.threads = beam_options.threads;
+			options.mcts.threads = beam_options.threads;
+		}
+		else if (arg == "--rollouts")
+		{
+			options.rollouts = std::atoi(argv[i + 1]);
+		}
+		else if (arg == "--rollout-pieces")
+		{
+			options.rollout.pieces = std::atoi(argv[i + 1]);
+			options.mcts.rollout_pieces = options.rollout.pieces;
+		}
+		else if (arg == "--mcts")
+		{
+			options.use_mcts = true;
+			options.mcts.simulations = std::atoi(argv[i + 1]);
+		}
+		else
+		{
+			std::cerr << "Unknown option: " << arg << std::endl;
+			return 1;
+		}
+	}
+
+	const int width = 10;
+	const int height = 20;
+	long long pieces = 0;
+	long long lines = 0;
+	long long nodes = 0;
+	long long duplicates = 0;
+	long long reused = 0;
+	beam_options.width = options.beam_width;
+	BeamSearch beam_search(beam_options, options.reachability);
+	MctsSearch mcts_search(options.mcts, options.reachability);
+	Solver solver;
+	solver.set_reachability(options.reachability);
+	RolloutOptions rollout_options = options.rollout;
+	rollout_options.rollouts = options.rollouts;
+	RolloutEvaluator rollout_evaluator(rollout_options);
+	if (options.rollouts > 0)
+	{
+		solver.set_leaf_evaluator(rollout_evaluator.leaf_evaluator());
+	}
+	auto start = std::chrono::steady_clock::now();
+
+	for (int game = 0; game < games; ++game)
+	{
+		std::mt19937 random_engine(seed + game);
+		std::uniform_int_distribution<int> random_type(0, Piece::type_count - 1);
+		PlayField play_field(width, height, buffer_rows);
+		std::deque<int> types;
+
+		for (int piece = 0; piece < max_pieces; ++piece)
+		{
+			while (static_cast<int>(types.size()) < lookahead + 1)
+			{
+				types.push_back(random_type(random_engine));
+			}
+			std::vector<Piece> queue;
+			for (int type : types)
+			{
+				queue.push_back(Piece::make(type, width / 2, play_field.get_spawn_y(), 0));
+			}
+			if (play_field.test_collision(queue.front()))
+			{
+				break;
+			}
+
+			Solver::Move move;
+			if (options.beam_width > 0)
+			{
+				move = beam_search.find_move(play_field, queue);
+			}
+			else if (options.use_mcts)
+			{
+				move = mcts_search.find_move(play_field, queue, options.time_budget_ms);
+			}
+			else
+			{
+				move = solver.find_move(play_field, queue, options.time_budget_ms);
+			}
+			nodes += move.nodes;
+			duplicates += move.duplicates;
+			reused += move.reused;
+			if (!move.found || !play_field.imprint(move.placement))
+			{
+				break;
+			}
+			types.pop_front();
+			++pieces;
+		}
+		lines += play_field.get_cleared_rows();
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	double seconds = std::max(elapsed.count(), 1e-9);
+	std::cout << "games: " << games
+		<< ", pieces: " << pieces
+		<< ", lines: " << lines
+		<< ", nodes: " << nodes
+		<< ", duplicates: " << duplicates
+		<< ", reused: " << reused
+		<< ", " << pieces / seconds << " pieces/s"
+		<< ", " << nodes / seconds << " nodes/s" << std::endl;
+	if (options.beam_width > 0)
+	{
+		const BeamSearch::Stats& stats = beam_search.get_stats();
+		std::cout << "beam: " << stats.children << " boards scored, "
+			<< 100.0 * stats.pruned / std::max(stats.children, 1LL) << "% pruned" << std::endl;
+	}
+	if (options.use_mcts)
+	{
+		const MctsSearch::Stats& stats = mcts_search.get_stats();
+		std::cout << "mcts: " << stats.simulations << " simulations, "
+			<< stats.reused_visits / std::max(pieces, 1LL) << " visits per move kept from the move before" << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,236 @@
+/*	Checks of the engine, run by ctest. Each check prints what failed, the
+ *	program exits with the number of failed checks.
+ */
+
+#include "Engine.h"
+#include "EvaluationFunctions.h"
+#include "PlacementGenerator.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <random>
+
+namespace
+{
+	int failures = 0;
+
+	void check(bool passed, const char* what)
+	{
+		if (!passed)
+		{
+			std::cerr << "FAILED: " << what << std::endl;
+			++failures;
+		}
+	}
+
+	bool same_piece(const Piece& a, const Piece& b)
+	{
+		return a.get_type() == b.get_type()
+			&& a.get_x() == b.get_x()
+			&& a.get_y() == b.get_y()
+			&& a.get_rotation() == b.get_rotation();
+	}
+
+	/* A stack of up to eight rows with a few holes in each. */
+	PlayField random_play_field(std::mt19937& random_engine, int width, int height)
+	{
+		PlayField play_field(width, height);
+		int rows = std::uniform_int_distribution<int>(0, 8)(random_engine);
+		for (int y = height - rows; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				play_field.set(x, y, std::uniform_int_distribution<int>(0, 3)(random_engine) != 0);
+			}
+			play_field.set(std::uniform_int_distribution<int>(0, width - 1)(random_engine), y, false);
+		}
+		return play_field;
+	}
+
+	/*	Every placement of the first piece has to be scored by the best
+		placement of the second below it. The depth-1 visited flags were once
+		left over from the first branch, so later branches found no second
+		placement, and their values were never compared. */
+	void test_sibling_branches()
+	{
+		const int width = 10;
+		const int height = 20;
+		std::mt19937 random_engine(1);
+		Solver solver;
+		for (int board = 0; board < 200; ++board)
+		{
+			PlayField play_field = random_play_field(random_engine, width, height);
+			std::vector<Piece> queue;
+			for (int i = 0; i < 2; ++i)
+			{
+				int type = std::uniform_int_distribution<int>(0, Piece::type_count - 1)(random_engine);
+				queue.push_back(Piece::make(type, width / 2, play_field.get_spawn_y(), 0));
+			}
+			if (play_field.test_collision(queue[0]))
+			{
+				continue;
+			}
+
+			/* searched by hand, ties go to the first placement found */
+			PlacementGenerator first_generator;
+			PlacementGenerator second_generator;
+			std::vector<Piece> firsts;
+			std::vector<Piece> seconds;
+			first_generator.generate(play_field, queue[0], firsts);
+			int best = -1;
+			double best_value = 0;
+			for (int i = 0; i < static_cast<int>(firsts.size()); ++i)
+			{
+				PlayField next_play_field = play_field;
+				next_play_field.imprint(firsts[i]);
+				second_generator.generate(next_play_field, queue[1], seconds);
+				double value = std::numeric_limits<double>::infinity();
+				for (auto& second : seconds)
+				{
+					PlayField last_play_field = next_play_field;
+					last_play_field.imprint(second);
+					std::vector<Piece> locked = { firsts[i], second };
+					value = std::min(value, solver.evaluate(play_field, last_play_field, locked));
+				}
+				if (best == -1 || best_value > value)
+				{
+					best = i;
+					best_value = value;
+				}
+			}
+
+			Solver::Move move = solver.find_move(play_field, queue, 0);
+			check(move.found == (best != -1), "sibling branches: a move is found when the piece can lock");
+			check(!move.found || move.depth == 2, "sibling branches: the whole queue is searched");
+			check(!move.found || same_piece(move.placement, firsts[best]), "sibling branches: the placement with the best second piece is chosen");
+		}
+	}
+
+	/*	Lines cleared between from and to have to lower the score. The count
+		was once taken as from - to, which made clears cost more than none. */
+	void test_lines_cleared_sign()
+	{
+		PlayField from(10, 20);
+		for (int y = 18; y < 20; ++y)
+		{
+			for (int x = 2; x < 10; ++x)
+			{
+				from.set(x, y, true);
+			}
+		}
+		PlacementGenerator generator;
+		std::vector<Piece> placements;
+		generator.generate(from, Piece::make(0, 5, 0, 0), placements);
+		Solver solver;
+		bool cleared = false;
+		for (auto& placement : placements)
+		{
+			PlayField to = from;
+			to.imprint(placement);
+			std::vector<Piece> locked(1, placement);
+			double lines = EvaluationFunction<0>()(from, to, locked);
+			if (to.get_cleared_rows() == 2)
+			{
+				cleared = true;
+				check(lines == 1.5, "lines cleared: two lines score as two");
+			}
+			else
+			{
+				check(lines == -1.0, "lines cleared: no line scores as none");
+			}
+		}
+		check(cleared, "lines cleared: the O piece fills the gap");
+		check(EvaluationFunction<0>::weight() * 1.5 < EvaluationFunction<0>::weight() * -1.0, "lines cleared: clearing lowers the score");
+	}
+
+	/* Piece ids only hold 64 rows, taller fields get no move instead of an exception. */
+	void test_row_limit()
+	{
+		PlayField play_field(10, 60, 10);
+		std::vector<Piece> queue(2, Piece::make(0, 5, play_field.get_spawn_y(), 0));
+		Solver solver;
+		Solver::Move move = solver.find_move(play_field, queue, 0);
+		check(!move.found, "row limit: no move on a field over 64 rows");
+		PlayField highest(10, 54, 10);
+		move = solver.find_move(highest, queue, 0);
+		check(move.found, "row limit: a move on a field of 64 rows");
+	}
+
+	/*	Without open overhangs every placement is a straight drop, and the
+		generator lands those without searching the rows. It has to find the
+		same placements as the search, at any gravity. */
+	void test_straight_drops()
+	{
+		const int width = 10;
+		const int height = 20;
+		std::mt19937 random_engine(3);
+		const Reachability reachabilities[] = { Reachability(), Reachability(1.0, 1.0) };
+		int boards = 0;
+		for (int board = 0; board < 300; ++board)
+		{
+			PlayField play_field = random_play_field(random_engine, width, height);
+			if (play_field.has_open_overhangs())
+			{
+				continue;
+			}
+			++boards;
+			for (auto& reachability : reachabilities)
+			{
+				PlacementGenerator fast_generator(reachability);
+				PlacementGenerator full_generator(reachability);
+				full_generator.set_shortcuts(false);
+				for (int type = 0; type < Piece::type_count; ++type)
+				{
+					Piece spawn_piece = Piece::make(type, width / 2, play_field.get_spawn_y(), 0);
+					std::vector<Piece> fast;
+					std::vector<Piece> full;
+					fast_generator.generate(play_field, spawn_piece, fast);
+					full_generator.generate(play_field, spawn_piece, full);
+					bool same = fast.size() == full.size();
+					for (size_t i = 0; same && i < fast.size(); ++i)
+					{
+						same = same_piece(fast[i], full[i]);
+					}
+					check(same, "straight drops: the same placements as searching every row");
+				}
+			}
+		}
+		check(boards >= 50, "straight drops: enough boards without open overhangs");
+	}
+
+	/* Playouts are seeded by their index, not by the thread that plays them. */
+	void test_rollouts_deterministic()
+	{
+		const int width = 10;
+		const int height = 20;
+		std::mt19937 random_engine(2);
+		RolloutOptions options;
+		options.threads = 1;
+		RolloutEvaluator one_thread(options);
+		options.threads = 3;
+		RolloutEvaluator three_threads(options);
+		for (int board = 0; board < 20; ++board)
+		{
+			PlayField play_field = random_play_field(random_engine, width, height);
+			Piece piece = Piece::make(board % Piece::type_count, width / 2, 0, 0);
+			std::vector<Piece> locked(1, piece);
+			double value = one_thread.evaluate(play_field, play_field, locked);
+			check(value == three_threads.evaluate(play_field, play_field, locked), "rollouts: the score does not depend on the threads");
+			check(value == one_thread.evaluate(play_field, play_field, locked), "rollouts: the same leaf scores the same again");
+		}
+	}
+}
+
+int main()
+{
+	test_sibling_branches();
+	test_lines_cleared_sign();
+	test_row_limit();
+	test_straight_drops();
+	test_rollouts_deterministic();
+	if (failures == 0)
+	{
+		std::cout << "all engine checks passed" << std::endl;
+	}
+	return failures;
+}
@@ -0,0 +1,152 @@
+/*	Checks of the replay and dataset files, run by ctest in the build
+ *	directory, where the files are written. Each check prints what failed,
+ *	the program exits with the number of failed checks.
+ */
+
+#include "Dataset.h"
+#include "PlayField.h"
+#include "Replay.h"
+#include <cstdio>
+#include <iostream>
+
+namespace
+{
+	int failures = 0;
+
+	void check(bool passed, const char* what)
+	{
+		if (!passed)
+		{
+			std::cerr << "FAILED: " << what << std::endl;
+			++failures;
+		}
+	}
+
+	bool same_piece(const Piece& a, const Piece& b)
+	{
+		return a.get_type() == b.get_type()
+			&& a.get_x() == b.get_x()
+			&& a.get_y() == b.get_y()
+			&& a.get_rotation() == b.get_rotation();
+	}
+
+	/* The piece with its highest tile in the top row of play_field. */
+	Piece highest(const PlayField& play_field, int type, int x)
+	{
+		Piece piece = Piece::make(type, x, 0, 0);
+		int first = 0;
+		while (piece.get_rows()[first] == 0)
+		{
+			++first;
+		}
+		return Piece::make(type, x, play_field.get_top() + PIECE_SIZE / 2 - first, 0);
+	}
+
+	/*	Records were y + 8 in 6 bits, which wrapped for locks more than 8 rows
+		into the buffer. They count from the top buffer row now. */
+	void test_replay_buffer_rows()
+	{
+		const char* path = "format_tests.tsrp";
+		const int width = 10;
+		const int height = 20;
+		const int buffer_rows = 20;
+		PlayField play_field(width, height, buffer_rows);
+		std::vector<Piece> pieces;
+		for (int type = 0; type < Piece::type_count; ++type)
+		{
+			pieces.push_back(highest(play_field, type, type + 1));
+		}
+		pieces.push_back(Piece::make(0, 4, height - 1, 0));
+
+		std::remove(path);
+		{
+			ReplayWriter writer(path);
+			check(writer.is_open(), "replay: the file opens for writing");
+			writer.begin_game(ReplayHeader(1, width, height, buffer_rows));
+			for (auto& piece : pieces)
+			{
+				check(writer.add_placement(piece), "replay: a placement on the field is written");
+			}
+			writer.end_game();
+		}
+
+		ReplayReader reader(path);
+		ReplayHeader header;
+		check(reader.next_game(header), "replay: the game is read back");
+		check(header.buffer_rows == buffer_rows, "replay: the header keeps the buffer rows");
+		Piece piece;
+		size_t read = 0;
+		while (reader.next_placement(piece))
+		{
+			check(read < pieces.size() && same_piece(piece, pieces[read]), "replay: a lock in the top buffer row reads back where it was");
+			++read;
+		}
+		check(read == pieces.size(), "replay: every placement is read back");
+		check(!reader.next_game(header), "replay: nothing follows the game");
+		std::remove(path);
+
+		uint16_t record;
+		check(!ReplayFormat::encode(Piece::make(0, 4, 60, 0), buffer_rows, record), "replay: a piece out of range does not encode");
+		check(ReplayFormat::encode(Piece::make(2, 3, 5, 1), 0, record) && record == (2 | 1 << 3 | 7 << 5 | 13 << 10), "replay: records without buffer rows are unchanged");
+	}
+
+	/* Datasets used to keep the visible rows only, and lose the buffer. */
+	void test_dataset_buffer_rows()
+	{
+		const char* path = "format_tests.tsds";
+		PlayField play_field(10, 20, 20);
+		play_field.set(0, -20, true);
+		play_field.set(9, -1, true);
+		play_field.set(3, 19, true);
+		{
+			DatasetWriter writer(path, 10, 20, 20);
+			check(writer.is_open(), "dataset: the file opens for writing");
+			writer.add(play_field, 1, 2, 3.0f);
+		}
+		{
+			PositionDataset dataset(path);
+			check(dataset.is_open() && dataset.size() == 1, "dataset: the record is read back");
+			check(dataset.get_buffer_rows() == 20, "dataset: the header keeps the buffer rows");
+			check(dataset.make_play_field(0) == play_field, "dataset: the buffer rows read back");
+			check(dataset.get_current_piece(0) == 1 && dataset.get_next_piece(0) == 2 && dataset.get_label(0) == 3.0f, "dataset: the pieces and label follow the rows");
+		}
+		std::remove(path);
+	}
+
+	/* Rows are 16 bits, wider boards used to lose their other columns. */
+	void test_dataset_width()
+	{
+		const char* path = "format_tests.tsds";
+		std::remove(path);
+		{
+			DatasetWriter writer(path, 17, 20);
+			check(!writer.is_open(), "dataset: a board over 16 wide is not written");
+		}
+		{
+			DatasetWriter writer(path, 16, 20);
+			check(writer.is_open(), "dataset: a board 16 wide is written");
+			writer.add(PlayField(16, 20), 0, 0, 0.0f);
+		}
+		std::FILE* file = std::fopen(path, "r+b");
+		const unsigned char width = 17;
+		check(file != nullptr && std::fseek(file, 5, SEEK_SET) == 0 && std::fwrite(&width, 1, 1, file) == 1, "dataset: the header can be patched");
+		if (file != nullptr)
+		{
+			std::fclose(file);
+		}
+		check(!PositionDataset(path).is_open(), "dataset: a header over 16 wide is not loaded");
+		std::remove(path);
+	}
+}
+
+int main()
+{
+	test_replay_buffer_rows();
+	test_dataset_buffer_rows();
+	test_dataset_width();
+	if (failures == 0)
+	{
+		std::cout << "all format checks passed" << std::endl;
+	}
+	return failures;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <deque>
+
+/* An input the player can make on the falling piece. */
+enum Action { Rotate, Left, Right };
+
+/* The inputs that bring a piece from its spawn to where it locks, one frame
+	per row. Every frame is followed by the piece dropping a row. */
+typedef std::deque<std::deque<Action>> Recording;
@@ -0,0 +1,249 @@
+#include "BeamSearch.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+BeamSearch::Beam::Beam(size_t capacity)
+	: capacity_(capacity)
+	, pruned_(0)
+	, duplicates_(0)
+{
+	nodes_.reserve(capacity);
+	heap_.reserve(capacity);
+}
+
+void BeamSearch::Beam::offer(Node&& node)
+{
+	/* a max-heap on value, so the worst node kept is always at the front */
+	auto less_good = [this](size_t a, size_t b) { return nodes_[a].value < nodes_[b].value; };
+	auto same_hash = slots_.equal_range(node.hash);
+	for (auto it = same_hash.first; it != same_hash.second; ++it)
+	{
+		Node& kept = nodes_[it->second];
+		if (kept.play_field == node.play_field)
+		{
+			++duplicates_;
+			if (node.value < kept.value)
+			{
+				kept = std::move(node);
+				std::make_heap(heap_.begin(), heap_.end(), less_good);
+			}
+			return;
+		}
+	}
+	if (heap_.size() < capacity_)
+	{
+		slots_.emplace(node.hash, nodes_.size());
+		heap_.push_back(nodes_.size());
+		nodes_.push_back(std::move(node));
+		std::push_heap(heap_.begin(), heap_.end(), less_good);
+		return;
+	}
+	++pruned_;
+	if (capacity_ == 0 || node.value >= nodes_[heap_.front()].value)
+	{
+		return;
+	}
+	std::pop_heap(heap_.begin(), heap_.end(), less_good);
+	size_t slot = heap_.back();
+	erase_slot(slot);
+	slots_.emplace(node.hash, slot);
+	nodes_[slot] = std::move(node);
+	std::push_heap(heap_.begin(), heap_.end(), less_good);
+}
+
+void BeamSearch::Beam::erase_slot(size_t slot)
+{
+	auto same_hash = slots_.equal_range(nodes_[slot].hash);
+	for (auto it = same_hash.first; it != same_hash.second; ++it)
+	{
+		if (it->second == slot)
+		{
+			slots_.erase(it);
+			return;
+		}
+	}
+}
+
+void BeamSearch::Beam::merge(Beam& other)
+{
+	for (size_t slot : other.heap_)
+	{
+		offer(std::move(other.nodes_[slot]));
+	}
+	pruned_ += other.pruned_;
+	duplicates_ += other.duplicates_;
+	other.nodes_.clear();
+	other.heap_.clear();
+	other.slots_.clear();
+	other.pruned_ = 0;
+	other.duplicates_ = 0;
+}
+
+std::vector<BeamSearch::Node> BeamSearch::Beam::take_nodes()
+{
+	std::vector<Node> nodes;
+	nodes.reserve(heap_.size());
+	for (size_t slot : heap_)
+	{
+		nodes.push_back(std::move(nodes_[slot]));
+	}
+	nodes_.clear();
+	heap_.clear();
+	slots_.clear();
+	return nodes;
+}
+
+void BeamSearch::Beam::restore(std::vector<Node>&& nodes)
+{
+	/* they came out in heap order, so they still form a heap */
+	nodes_ = std::move(nodes);
+	for (size_t slot = 0; slot < nodes_.size(); ++slot)
+	{
+		heap_.push_back(slot);
+		slots_.emplace(nodes_[slot].hash, slot);
+	}
+}
+
+BeamSearch::BeamSearch(const BeamOptions& options, const Reachability& reachability)
+	: options_(options)
+	, reachability_(reachability)
+{
+	evaluator_.set_reachability(reachability);
+}
+
+void BeamSearch::expand(const PlayField& root, const Node& node, const Piece& piece, PlacementGenerator& generator, std::vector<Piece>& placements, Beam& beam) const
+{
+	generator.generate(node.play_field, piece, placements);
+	for (auto& placement : placements)
+	{
+		Node child;
+		child.play_field = node.play_field;
+		PROFILE_COUNT(PlayFieldCopies);
+		if (!child.play_field.imprint(placement))
+		{
+			continue;
+		}
+		child.hash = child.play_field.hash();
+		child.locked = node.locked;
+		child.locked.push_back(placement);
+		child.root = node.root;
+		child.value = evaluator_.evaluate(root, child.play_field, child.locked);
+		beam.offer(std::move(child));
+	}
+}
+
+Solver::Move BeamSearch::find_move(const PlayField& play_field, const std::vector<Piece>& piece_queue)
+{
+	TRACE_SCOPE("BeamSearch::find_move");
+	Solver::Move move;
+	size_t width = static_cast<size_t>(std::max(options_.width, 1));
+	int depth = static_cast<int>(piece_queue.size());
+	if (options_.depth > 0)
+	{
+		depth = std::min(depth, options_.depth);
+	}
+	int threads = options_.threads > 0 ? options_.threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+	/* the first level is expanded here, its generator is needed for the inputs of the chosen move */
+	PlacementGenerator root_generator(reachability_);
+	std::vector<Piece> root_placements;
+	root_generator.generate(play_field, piece_queue.front(), root_placements);
+	long long nodes = root_generator.get_nodes();
+	long long children = 0;
+	long long pruned = 0;
+	long long duplicates = 0;
+
+	Beam beam(width);
+	for (size_t i = 0; i < root_placements.size(); ++i)
+	{
+		Node child;
+		child.play_field = play_field;
+		if (!child.play_field.imprint(root_placements[i]))
+		{
+			continue;
+		}
+		child.hash = child.play_field.hash();
+		child.locked.push_back(root_placements[i]);
+		child.root = static_cast<int>(i);
+		child.value = evaluator_.evaluate(play_field, child.play_field, child.locked);
+		beam.offer(std::move(child));
+	}
+	children += static_cast<long long>(beam.size()) + beam.get_pruned() + beam.get_duplicates();
+	pruned += beam.get_pruned();
+	duplicates += beam.get_duplicates();
+	int levels = beam.empty() ? 0 : 1;
+
+	for (int level = 1; level < depth && !beam.empty(); ++level)
+	{
+		TRACE_SCOPE("BeamSearch::level");
+		std::vector<Node> parents = beam.take_nodes();
+		std::vector<Beam> beams(threads, Beam(width));
+		std::vector<long long> thread_nodes(threads, 0);
+		std::atomic<size_t> next_parent(0);
+		const Piece& piece = piece_queue[level];
+
+		/* parents are handed out one at a time, the children go to a beam per thread */
+		auto work = [&](int t)
+		{
+			PlacementGenerator generator(reachability_);
+			std::vector<Piece> placements;
+			size_t i;
+			while ((i = next_parent++) < parents.size())
+			{
+				expand(play_field, parents[i], piece, generator, placements, beams[t]);
+			}
+			thread_nodes[t] = generator.get_nodes();
+		};
+		std::vector<std::thread> workers;
+		for (int t = 1; t < threads; ++t)
+		{
+			workers.emplace_back(work, t);
+		}
+		work(0);
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+
+		Beam merged(width);
+		for (int t = 0; t < threads; ++t)
+		{
+			children += static_cast<long long>(beams[t].size()) + beams[t].get_pruned() + beams[t].get_duplicates();
+			nodes += thread_nodes[t];
+			merged.merge(beams[t]);
+		}
+		pruned += merged.get_pruned();
+		duplicates += merged.get_duplicates();
+		if (merged.empty())
+		{
+			/* every board of the beam is lost with this piece, rank them by the level before */
+			beam.restore(std::move(parents));
+			break;
+		}
+		beam = std::move(merged);
+		++levels;
+	}
+
+	stats_.nodes += nodes;
+	stats_.children += children;
+	stats_.pruned += pruned;
+	stats_.duplicates += duplicates;
+	move.nodes = nodes;
+	move.duplicates = duplicates;
+
+	std::vector<Node> kept = beam.take_nodes();
+	if (kept.empty())
+	{
+		move.recording.emplace_back();
+		return move;
+	}
+	auto best = std::min_element(kept.begin(), kept.end(), [](const Node& a, const Node& b) { return a.value < b.value; });
+	move.found = true;
+	move.placement = root_placements[best->root];
+	move.recording = root_generator.make_recording(move.placement);
+	move.depth = levels;
+	return move;
+}
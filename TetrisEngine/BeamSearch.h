@@ -0,0 +1,108 @@
+#pragma once
+
+/*	Looks further ahead than Solver::search can afford by only following the
+	most promising boards. Every level expands each board of the beam with all
+	placements of the next queue piece, scores the children with the Solver's
+	evaluation and keeps the best width of them for the next level. */
+
+#include "Solver.h"
+#include "PlacementGenerator.h"
+#include <unordered_map>
+
+struct BeamOptions
+{
+	BeamOptions()
+		: width(64), depth(0), threads(0)
+	{}
+
+	/* boards kept per level */
+	int width;
+	/* queue pieces to look at, 0 uses the whole queue */
+	int depth;
+	/* threads expanding a level, 0 uses one per core */
+	int threads;
+};
+
+class BeamSearch
+{
+public:
+	struct Stats
+	{
+		Stats()
+			: nodes(0), children(0), pruned(0), duplicates(0)
+		{}
+
+		/* positions expanded while generating placements */
+		long long nodes;
+		/* boards scored */
+		long long children;
+		/* boards scored but left out of the beam */
+		long long pruned;
+		/* boards scored that were already in the beam, only the better
+			valued one of the two is kept */
+		long long duplicates;
+	};
+
+	explicit BeamSearch(const BeamOptions& options, const Reachability& reachability = Reachability());
+
+	/* Same contract as Solver::find_move, the queue pieces must be at their
+		spawn position. */
+	Solver::Move find_move(const PlayField& play_field, const std::vector<Piece>& piece_queue);
+
+	/* totals over every find_move so far */
+	const Stats& get_stats() const { return stats_; }
+private:
+	struct Node
+	{
+		Node()
+			: play_field(0, 0), hash(0), root(-1), value(0.0)
+		{}
+
+		PlayField play_field;
+		/* PlayField::hash of play_field */
+		uint64_t hash;
+		std::vector<Piece> locked;
+		/* which placement of the first piece this board descends from */
+		int root;
+		double value;
+	};
+
+	/*	Keeps the width best nodes offered to it, the worst one on top. A
+		node whose board is already in the beam only replaces the one there
+		if it is better, so every board is kept and expanded at most once.
+		Boards are looked up by hash, only a hash match compares tiles. */
+	class Beam
+	{
+	public:
+		explicit Beam(size_t capacity);
+		void offer(Node&& node);
+		void merge(Beam& other);
+		bool empty() const { return heap_.empty(); }
+		size_t size() const { return heap_.size(); }
+		/* Empties the beam, the nodes come out in heap order. */
+		std::vector<Node> take_nodes();
+		/* Refills an empty beam with what take_nodes returned. */
+		void restore(std::vector<Node>&& nodes);
+		long long get_pruned() const { return pruned_; }
+		long long get_duplicates() const { return duplicates_; }
+	private:
+		void erase_slot(size_t slot);
+
+		size_t capacity_;
+		/* the nodes where they were put, a replaced node takes over its slot */
+		std::vector<Node> nodes_;
+		/* slots of nodes_ as a max-heap on value */
+		std::vector<size_t> heap_;
+		/* slots of nodes_ by Node::hash */
+		std::unordered_multimap<uint64_t, size_t> slots_;
+		long long pruned_;
+		long long duplicates_;
+	};
+
+	void expand(const PlayField& root, const Node& node, const Piece& piece, PlacementGenerator& generator, std::vector<Piece>& placements, Beam& beam) const;
+
+	BeamOptions options_;
+	Reachability reachability_;
+	Solver evaluator_;
+	Stats stats_;
+};
@@ -0,0 +1,27 @@
+#include "Engine.h"
+
+Solver::Move best_move(const PlayField& play_field, const std::vector<Piece>& piece_queue, const SearchOptions& options)
+{
+	if (options.beam_width > 0)
+	{
+		BeamOptions beam = options.beam;
+		beam.width = options.beam_width;
+		return BeamSearch(beam, options.reachability).find_move(play_field, piece_queue);
+	}
+	if (options.use_mcts)
+	{
+		return MctsSearch(options.mcts, options.reachability).find_move(play_field, piece_queue, options.time_budget_ms, options.stop);
+	}
+
+	Solver solver;
+	solver.set_reachability(options.reachability);
+	if (options.rollouts > 0)
+	{
+		RolloutOptions rollout = options.rollout;
+		rollout.rollouts = options.rollouts;
+		RolloutEvaluator evaluator(rollout);
+		solver.set_leaf_evaluator(evaluator.leaf_evaluator());
+		return solver.find_move(play_field, piece_queue, options.time_budget_ms, options.stop);
+	}
+	return solver.find_move(play_field, piece_queue, options.time_budget_ms, options.stop);
+}
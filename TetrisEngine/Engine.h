@@ -0,0 +1,42 @@
+#pragma once
+
+/*	The entry point for embedding the search. Only depends on the standard
+	library, so a program can link the engine without SDL or the game. */
+
+#include "Solver.h"
+#include "BeamSearch.h"
+#include "RolloutEvaluator.h"
+#include "MctsSearch.h"
+#include "Reachability.h"
+#include <atomic>
+#include <vector>
+
+struct SearchOptions
+{
+	SearchOptions()
+		: time_budget_ms(0), stop(nullptr), beam_width(0), rollouts(0), use_mcts(false)
+	{}
+
+	/* 0 searches the whole queue */
+	int time_budget_ms;
+	Reachability reachability;
+	/* if given, setting it ends the search early */
+	const std::atomic<bool>* stop;
+	/* above 0 a beam search of this width is used, the time budget and stop
+		flag then do not apply */
+	int beam_width;
+	BeamOptions beam;
+	/* above 0 the leaves of the search are scored with this many playouts
+		each, see RolloutEvaluator */
+	int rollouts;
+	RolloutOptions rollout;
+	/* searches with MctsSearch instead, which honours the time budget and
+		stop flag but starts without a tree on every call */
+	bool use_mcts;
+	MctsOptions mcts;
+};
+
+/*	Finds where to place the first piece of piece_queue on play_field, see
+	Solver::find_move. Keeps no state between calls, so any thread may call
+	it at any time. */
+Solver::Move best_move(const PlayField& play_field, const std::vector<Piece>& piece_queue, const SearchOptions& options);
@@ -1,6 +1,14 @@
 #pragma once
 
 #include "PlayField.h"
+#include <bitset>
+
+/*	The board terms below read whole rows through PlayField::get_row and
+	columns through get_column_top rather than a tile at a time. */
+inline int count_tiles(PlayField::Row row)
+{
+	return static_cast<int>(std::bitset<PlayField::max_width>(row).count());
+}
 
 template<int ID>
 struct EvaluationFunction
@@ -13,10 +21,12 @@ struct EvaluationFunction<0>
 {
 	/* Total Lines Cleared
 		This is the total number of lines cleared as a consequence of introducing the 2 Tetriminos.
+		The count only goes up, so it is to - from; read the other way round,
+		clears came out negative and were penalised.
 	*/
 	double operator()(const PlayField& from, const PlayField& to, const std::vector<Piece>& locked_pieces)
 	{
-		int lines_cleared = from.get_cleared_rows() - to.get_cleared_rows();
+		int lines_cleared = to.get_cleared_rows() - from.get_cleared_rows();
 		if (lines_cleared == 0)
 		{
 			return -1.0f;
@@ -37,7 +47,7 @@ struct EvaluationFunction<0>
 		{
 			return 8.0f;
 		}
-		return static_cast<double>(from.get_cleared_rows() - to.get_cleared_rows());
+		return static_cast<double>(lines_cleared);
 	};
 	
 	static double weight()
@@ -105,28 +115,22 @@ struct EvaluationFunction<2>
 	*/
 	double operator()(const PlayField& from, const PlayField& to, const std::vector<Piece>& locked_pieces)
 	{
+		/* the empty cell on top of each column that is neither empty nor full to the top */
 		int wall_cells = 0;
 		for (int x = 0; x < to.get_width(); ++x)
 		{
-			int first_top = -1;
-			for (int y = 0; y < to.get_height(); ++y)
+			int column_top = to.get_column_top(x);
+			if (column_top == to.get_top() || column_top == to.get_height())
 			{
-				if (to.get(x, y))
-				{
-					first_top = y - 1;
-					break;
-				}
+				continue;
 			}
-			if (first_top != -1 && first_top != to.get_height() - 1)
+			if (x == 0 || x == to.get_width() - 1)
 			{
-				if (x == 0 || x == to.get_width() - 1)
-				{
-					wall_cells++;
-				}
-				else if (!to.get(x - 1, first_top) && !to.get(x + 1, first_top))
-				{
-					wall_cells++;
-				}
+				wall_cells++;
+			}
+			else if (((to.get_row(column_top - 1) >> (x - 1)) & 5) == 0)
+			{
+				wall_cells++;
 			}
 		}
 		return static_cast<double>(wall_cells);
@@ -151,16 +155,9 @@ struct EvaluationFunction<3>
 	double operator()(const PlayField& from, const PlayField& to, const std::vector<Piece>& locked_pieces)
 	{
 		int holes = 0;
-		for (int x = 0; x < to.get_width(); ++x)
+		for (int y = to.get_top() + 1; y < to.get_height() - 1; ++y)
 		{
-			for (int y = 1; y < to.get_height() - 1; ++y)
-			{
-				if (!to.get(x, y) && to.get(x, y - 1))
-				{
-					holes++;
-				}
-			}
-			
+			holes += count_tiles(to.get_row(y - 1) & ~to.get_row(y));
 		}
 		return static_cast<double>(holes);
 	};
@@ -185,16 +182,9 @@ struct EvaluationFunction<4>
 	double operator()(const PlayField& from, const PlayField& to, const std::vector<Piece>& locked_pieces)
 	{
 		int transitions = 0;
-		for (int x = 0; x < to.get_width(); ++x)
+		for (int y = to.get_top() + 1; y < to.get_height(); ++y)
 		{
-			for (int y = 1; y < to.get_height(); ++y)
-			{
-				if (!to.get(x, y - 1) && to.get(x, y)) 
-				{
-					transitions++;
-				}
-			}
-
+			transitions += count_tiles(~to.get_row(y - 1) & to.get_row(y));
 		}
 		return static_cast<double>(transitions);
 	};
@@ -217,28 +207,14 @@ struct EvaluationFunction<5>
 	*/
 	double operator()(const PlayField& from, const PlayField& to, const std::vector<Piece>& locked_pieces)
 	{
+		/* Only the transition into the first solid cell of each row is
+			counted, which every row with a solid cell has, so this is the
+			number of rows that are not empty. The weights were tuned with it
+			counting that way. */
 		int transitions = 0;
-		for (int y = 1; y < to.get_height() - 1; ++y)
+		for (int y = to.get_top() + 1; y < to.get_height() - 1; ++y)
 		{
-			int this_row = 0;
-			bool empty = true;
-			for (int x = 0; x < to.get_width(); ++x)
-			{
-				if (to.get(x, y))
-				{
-					if (!to.get(x - 1, y))
-					{
-						transitions++;
-					}
-					empty = false;
-					break;
-				}
-			}
-			if (!empty)
-			{
-				transitions += this_row;
-			}
-
+			transitions += to.get_row(y) != 0 ? 1 : 0;
 		}
 		return static_cast<double>(transitions);
 	};
@@ -262,16 +238,9 @@ struct EvaluationFunction<6>
 	double operator()(const PlayField& from, const PlayField& to, const std::vector<Piece>& locked_pieces)
 	{
 		int pile_height = 0;
-		for (int y = 1; y < to.get_height() - 1; ++y)
+		for (int y = to.get_top() + 1; y < to.get_height() - 1; ++y)
 		{
-			for (int x = 0; x < to.get_width(); ++x)
-			{
-				if (to.get(x, y))
-				{
-					pile_height++;
-					break;
-				}
-			}
+			pile_height += to.get_row(y) != 0 ? 1 : 0;
 		}
 		return static_cast<double>(pile_height);
 	};
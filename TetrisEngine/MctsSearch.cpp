@@ -0,0 +1,433 @@
+#include "MctsSearch.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace
+{
+	/* what a node where the next piece cannot lock costs, worse than any board in play */
+	const double lost_cost = 10000.0;
+}
+
+MctsSearch::NodePool::NodePool(int capacity)
+	: capacity_(std::max(capacity, 1))
+{
+	/* reserved once, so nodes never move while the tree grows */
+	nodes_.reserve(capacity_);
+}
+
+int MctsSearch::NodePool::allocate(int count)
+{
+	if (size() + count > capacity_)
+	{
+		return -1;
+	}
+	int first = size();
+	nodes_.resize(nodes_.size() + count);
+	return first;
+}
+
+void MctsSearch::NodePool::compact(int root)
+{
+	std::vector<Node> kept;
+	kept.reserve(capacity_);
+	kept.push_back(nodes_[root]);
+	/* breadth first, which keeps every run of children together */
+	for (size_t i = 0; i < kept.size(); ++i)
+	{
+		int first_child = kept[i].first_child;
+		int child_count = kept[i].child_count;
+		if (child_count == 0)
+		{
+			continue;
+		}
+		kept[i].first_child = static_cast<int>(kept.size());
+		for (int c = 0; c < child_count; ++c)
+		{
+			kept.push_back(nodes_[first_child + c]);
+		}
+	}
+	nodes_.swap(kept);
+}
+
+MctsSearch::MctsSearch(const MctsOptions& options, const Reachability& reachability)
+	: options_(options)
+	, reachability_(reachability)
+	, pool_(options.max_nodes)
+	, root_field_(0, 0)
+	, worst_cost_(0.0)
+	, has_cost_(false)
+	, max_depth_(0)
+	, simulations_(0)
+	, target_(0)
+	, done_(false)
+	, has_deadline_(false)
+	, stop_(nullptr)
+	, has_tree_(false)
+	, chosen_child_(-1)
+	, expected_field_(0, 0)
+	, generation_(0)
+	, busy_(0)
+	, quit_(false)
+{
+	evaluator_.set_reachability(reachability);
+	int threads = options_.threads > 0 ? options_.threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+	for (int t = 0; t < threads; ++t)
+	{
+		RolloutOptions rollout_options;
+		rollout_options.rollouts = options_.rollouts;
+		rollout_options.pieces = options_.rollout_pieces;
+		rollout_options.threads = 1;
+		rollout_options.seed = options_.seed + static_cast<unsigned int>(t);
+		workers_.emplace_back(new Worker(rollout_options, reachability_));
+	}
+	for (int t = 1; t < threads; ++t)
+	{
+		threads_.emplace_back(&MctsSearch::work, this, t);
+	}
+}
+
+MctsSearch::~MctsSearch()
+{
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex_);
+		quit_ = true;
+	}
+	work_ready_.notify_all();
+	for (auto& thread : threads_)
+	{
+		thread.join();
+	}
+}
+
+MctsSearch::Node MctsSearch::make_node(const Piece& placement, double prior)
+{
+	Node node;
+	node.placement = placement;
+	node.first_child = -1;
+	node.child_count = 0;
+	node.visits = 0;
+	node.virtual_loss = 0;
+	node.total_cost = 0.0;
+	node.prior = prior;
+	node.expanding = false;
+	node.lost = false;
+	return node;
+}
+
+Solver::Move MctsSearch::find_move(const PlayField& play_field, const std::vector<Piece>& piece_queue, int time_budget_ms, const std::atomic<bool>* stop)
+{
+	TRACE_SCOPE("MctsSearch::find_move");
+	Solver::Move move;
+	has_deadline_ = time_budget_ms > 0;
+	deadline_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(time_budget_ms);
+	stop_ = stop;
+	target_ = options_.simulations > 0 ? options_.simulations : (has_deadline_ || stop != nullptr ? 0 : 1000);
+	simulations_ = 0;
+	max_depth_ = 1;
+	done_ = false;
+
+	prepare_root(play_field, piece_queue, *workers_[0]);
+	if (pool_[0].child_count > 0)
+	{
+		TRACE_SCOPE("MctsSearch::simulate");
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex_);
+			busy_ = static_cast<int>(threads_.size());
+			++generation_;
+		}
+		work_ready_.notify_all();
+		run_simulations(*workers_[0]);
+		std::unique_lock<std::mutex> lock(pool_mutex_);
+		work_done_.wait(lock, [this]() { return busy_ == 0; });
+	}
+
+	stats_.simulations += simulations_;
+	stats_.nodes = pool_.size();
+	move.nodes = simulations_;
+	Node& root = pool_[0];
+	if (root.child_count == 0)
+	{
+		move.recording.emplace_back();
+		return move;
+	}
+
+	/* the most visited child, with the prior breaking ties before anything is visited */
+	int best = root.first_child;
+	for (int c = root.first_child; c < root.first_child + root.child_count; ++c)
+	{
+		const Node& child = pool_[c];
+		if (child.visits > pool_[best].visits || (child.visits == pool_[best].visits && child.prior > pool_[best].prior))
+		{
+			best = c;
+		}
+	}
+	move.found = true;
+	move.placement = pool_[best].placement;
+	move.depth = max_depth_;
+
+	PlacementGenerator generator(reachability_);
+	std::vector<Piece> placements;
+	generator.generate(root_field_, queue_.front(), placements);
+	move.recording = generator.make_recording(move.placement);
+
+	has_tree_ = true;
+	chosen_child_ = best;
+	expected_field_ = root_field_;
+	expected_field_.imprint(move.placement);
+	expected_types_.clear();
+	for (size_t i = 1; i < queue_.size(); ++i)
+	{
+		expected_types_.push_back(queue_[i].get_type());
+	}
+	return move;
+}
+
+void MctsSearch::prepare_root(const PlayField& play_field, const std::vector<Piece>& piece_queue, Worker& worker)
+{
+	bool reuse = has_tree_ && expected_types_.size() <= piece_queue.size() && play_field == expected_field_;
+	for (size_t i = 0; reuse && i < expected_types_.size(); ++i)
+	{
+		reuse = piece_queue[i].get_type() == expected_types_[i];
+	}
+	has_tree_ = false;
+
+	if (reuse)
+	{
+		pool_.compact(chosen_child_);
+		stats_.reused_visits += pool_[0].visits;
+	}
+	else
+	{
+		pool_.clear();
+		pool_.allocate(1);
+		pool_[0] = make_node(Piece(), 0.0);
+	}
+	root_field_ = play_field;
+	queue_ = piece_queue;
+	/* a reused tree already knows how bad a visit can get */
+	worst_cost_ = 0.0;
+	has_cost_ = false;
+	for (int i = 0; i < pool_.size(); ++i)
+	{
+		if (pool_[i].visits > 0)
+		{
+			worst_cost_ = std::max(worst_cost_, pool_[i].total_cost / pool_[i].visits);
+			has_cost_ = true;
+		}
+	}
+
+	Node& root = pool_[0];
+	if (root.child_count == 0 && !root.lost)
+	{
+		std::vector<Node> children;
+		if (expand(worker, root_field_, queue_.front(), children))
+		{
+			int first = pool_.allocate(static_cast<int>(children.size()));
+			if (first != -1)
+			{
+				std::copy(children.begin(), children.end(), &pool_[first]);
+				pool_[0].first_child = first;
+				pool_[0].child_count = static_cast<int>(children.size());
+			}
+		}
+	}
+}
+
+bool MctsSearch::out_of_time()
+{
+	return (stop_ != nullptr && stop_->load(std::memory_order_relaxed))
+		|| (has_deadline_ && std::chrono::steady_clock::now() > deadline_);
+}
+
+void MctsSearch::work(int index)
+{
+	int seen = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(pool_mutex_);
+			work_ready_.wait(lock, [&]() { return quit_ || generation_ != seen; });
+			if (quit_)
+			{
+				return;
+			}
+			seen = generation_;
+		}
+		run_simulations(*workers_[index]);
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex_);
+			--busy_;
+		}
+		work_done_.notify_one();
+	}
+}
+
+void MctsSearch::run_simulations(Worker& worker)
+{
+	while (!done_)
+	{
+		if (out_of_time())
+		{
+			done_ = true;
+			break;
+		}
+		simulate(worker);
+	}
+}
+
+void MctsSearch::simulate(Worker& worker)
+{
+	worker.path.clear();
+	worker.locked.clear();
+	bool expand_leaf = false;
+	bool lost = false;
+	int leaf = 0;
+	{
+		/* walk down, marking the path with a virtual loss so other threads look elsewhere */
+		std::lock_guard<std::mutex> lock(tree_mutex_);
+		worker.path.push_back(0);
+		while (pool_[leaf].child_count > 0)
+		{
+			leaf = select_child(pool_[leaf]);
+			++pool_[leaf].virtual_loss;
+			worker.path.push_back(leaf);
+			worker.locked.push_back(pool_[leaf].placement);
+		}
+		Node& node = pool_[leaf];
+		lost = node.lost;
+		if (!lost && !node.expanding && worker.locked.size() < queue_.size() && pool_.has_room())
+		{
+			node.expanding = true;
+			expand_leaf = true;
+		}
+	}
+
+	/* everything slow happens without the lock */
+	PlayField play_field = root_field_;
+	for (auto& piece : worker.locked)
+	{
+		play_field.imprint(piece);
+	}
+	std::vector<Node> children;
+	if (expand_leaf && !expand(worker, play_field, queue_[worker.locked.size()], children))
+	{
+		lost = true;
+	}
+	double cost = lost_cost;
+	if (!lost)
+	{
+		cost = worker.rollouts.evaluate(root_field_, play_field, worker.locked);
+	}
+
+	std::lock_guard<std::mutex> lock(tree_mutex_);
+	if (expand_leaf)
+	{
+		pool_[leaf].expanding = false;
+		pool_[leaf].lost = lost;
+		int first = lost ? -1 : pool_.allocate(static_cast<int>(children.size()));
+		if (first != -1)
+		{
+			std::copy(children.begin(), children.end(), &pool_[first]);
+			pool_[leaf].first_child = first;
+			pool_[leaf].child_count = static_cast<int>(children.size());
+		}
+	}
+	for (int index : worker.path)
+	{
+		Node& node = pool_[index];
+		++node.visits;
+		node.total_cost += cost;
+		if (index != 0)
+		{
+			--node.virtual_loss;
+		}
+	}
+	worst_cost_ = has_cost_ ? std::max(worst_cost_, cost) : cost;
+	has_cost_ = true;
+	max_depth_ = std::max(max_depth_, static_cast<int>(worker.locked.size()));
+	++simulations_;
+	if (target_ > 0 && simulations_ >= target_)
+	{
+		done_ = true;
+	}
+}
+
+int MctsSearch::select_child(const Node& node) const
+{
+	/* Costs are turned into values in [0, 1] using the range seen among the
+		siblings, a virtual loss counts as a visit that found the worst cost.
+		Until a cost is known there is no worst one, a virtual loss then only
+		takes from the exploration bonus, it must not look like a cheap visit. */
+	double parent_mean = node.visits > 0 ? node.total_cost / node.visits : 0.0;
+	auto mean_of = [&](const Node& child)
+	{
+		if (has_cost_)
+		{
+			int visits = child.visits + child.virtual_loss;
+			return visits > 0 ? (child.total_cost + child.virtual_loss * worst_cost_) / visits : parent_mean;
+		}
+		return child.visits > 0 ? child.total_cost / child.visits : parent_mean;
+	};
+	double low = parent_mean;
+	double high = parent_mean;
+	for (int c = node.first_child; c < node.first_child + node.child_count; ++c)
+	{
+		const Node& child = pool_[c];
+		if (child.visits + child.virtual_loss > 0)
+		{
+			double mean = mean_of(child);
+			low = std::min(low, mean);
+			high = std::max(high, mean);
+		}
+	}
+
+	double exploration = options_.exploration * std::sqrt(static_cast<double>(node.visits + node.virtual_loss + 1));
+	int best = node.first_child;
+	double best_score = -1.0;
+	for (int c = node.first_child; c < node.first_child + node.child_count; ++c)
+	{
+		const Node& child = pool_[c];
+		int visits = child.visits + child.virtual_loss;
+		double mean = mean_of(child);
+		double value = high > low ? (high - mean) / (high - low) : 0.5;
+		double score = value + exploration * child.prior / (1 + visits);
+		if (score > best_score)
+		{
+			best = c;
+			best_score = score;
+		}
+	}
+	return best;
+}
+
+bool MctsSearch::expand(Worker& worker, const PlayField& play_field, const Piece& spawn_piece, std::vector<Node>& children) const
+{
+	worker.generator.generate(play_field, spawn_piece, worker.placements);
+	double best = 0.0;
+	for (auto& placement : worker.placements)
+	{
+		PlayField next_play_field = play_field;
+		if (!next_play_field.imprint(placement))
+		{
+			continue;
+		}
+		double value = evaluator_.evaluate(play_field, next_play_field, std::vector<Piece>(1, placement));
+		best = children.empty() ? value : std::min(best, value);
+		children.push_back(make_node(placement, value));
+	}
+
+	/* a softmax over the negated evaluations */
+	double total = 0.0;
+	for (auto& child : children)
+	{
+		child.prior = std::exp((best - child.prior) / options_.prior_temperature);
+		total += child.prior;
+	}
+	for (auto& child : children)
+	{
+		child.prior /= total;
+	}
+	return !children.empty();
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+/*	Monte Carlo tree search over placements, an alternative to Solver::search
+	that can stop after any simulation and still have a sensible answer.
+	A node is the board left by the placements on the way down to it, its
+	children are every placement of the next queue piece. Children are
+	ordered by priors from the weighted evaluation, leaves are scored with
+	a RolloutEvaluator. Several threads run simulations on the same tree,
+	virtual loss keeps them from all walking down the same path. The threads
+	and their rollout evaluators live as long as the search.
+
+	The tree is kept between calls. If the next board is the one the chosen
+	placement left and the queue moved on by one piece, the subtree under
+	that placement becomes the new root along with all its statistics. */
+
+#include "Solver.h"
+#include "PlacementGenerator.h"
+#include "RolloutEvaluator.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct MctsOptions
+{
+	MctsOptions()
+		: simulations(0), threads(0), exploration(1.5), prior_temperature(20.0)
+		, rollouts(8), rollout_pieces(4), max_nodes(1 << 18), seed(1)
+	{}
+
+	/* simulations per move, 0 runs until the time budget or stop flag
+		(or 1000 simulations if neither is given) */
+	int simulations;
+	/* threads running simulations, 0 uses one per core */
+	int threads;
+	/* how much the priors count against the values found so far */
+	double exploration;
+	/* evaluation difference that makes one prior e times another */
+	double prior_temperature;
+	/* playouts per leaf and pieces per playout */
+	int rollouts;
+	int rollout_pieces;
+	/* the tree stops growing at this many nodes */
+	int max_nodes;
+	unsigned int seed;
+};
+
+class MctsSearch
+{
+public:
+	struct Stats
+	{
+		Stats()
+			: simulations(0), reused_visits(0), nodes(0)
+		{}
+
+		/* totals over every find_move so far */
+		long long simulations;
+		/* visits the roots already had when their find_move started */
+		long long reused_visits;
+		/* nodes in the tree after the last find_move */
+		long long nodes;
+	};
+
+	explicit MctsSearch(const MctsOptions& options, const Reachability& reachability = Reachability());
+	~MctsSearch();
+	MctsSearch(const MctsSearch&) = delete;
+	MctsSearch& operator=(const MctsSearch&) = delete;
+
+	/* Same contract as Solver::find_move. The result is the most visited
+		placement of the first piece, its depth the deepest level reached. */
+	Solver::Move find_move(const PlayField& play_field, const std::vector<Piece>& piece_queue, int time_budget_ms, const std::atomic<bool>* stop = nullptr);
+
+	const Stats& get_stats() const { return stats_; }
+private:
+	struct Node
+	{
+		/* where the piece of the level above locked to get here */
+		Piece placement;
+		/* children are stored next to each other, -1 until expanded */
+		int first_child;
+		int child_count;
+		int visits;
+		int virtual_loss;
+		double total_cost;
+		double prior;
+		/* a thread is generating the children */
+		bool expanding;
+		/* the next piece cannot spawn, or no placement of it locks */
+		bool lost;
+	};
+
+	/* All nodes live in one block reserved up front, handed out in runs so
+		that the children of a node are contiguous. */
+	class NodePool
+	{
+	public:
+		explicit NodePool(int capacity);
+		/* Returns the first of count new nodes, -1 if the pool is full. */
+		int allocate(int count);
+		void clear() { nodes_.clear(); }
+		/* Drops everything outside the subtree of root, which becomes node 0. */
+		void compact(int root);
+		Node& operator[](int index) { return nodes_[index]; }
+		const Node& operator[](int index) const { return nodes_[index]; }
+		int size() const { return static_cast<int>(nodes_.size()); }
+		bool has_room() const { return size() < capacity_; }
+	private:
+		int capacity_;
+		std::vector<Node> nodes_;
+	};
+
+	/* What one thread needs to run simulations. */
+	struct Worker
+	{
+		Worker(const RolloutOptions& rollout_options, const Reachability& reachability)
+			: rollouts(rollout_options), generator(reachability)
+		{}
+
+		RolloutEvaluator rollouts;
+		PlacementGenerator generator;
+		std::vector<Piece> placements;
+		std::vector<int> path;
+		std::vector<Piece> locked;
+	};
+
+	static Node make_node(const Piece& placement, double prior);
+
+	/* Readies the root for play_field and piece_queue, keeping the subtree
+		of the last move if it still applies. */
+	void prepare_root(const PlayField& play_field, const std::vector<Piece>& piece_queue, Worker& worker);
+	bool out_of_time();
+	/* What the pool threads run, waiting for each find_move in turn. */
+	void work(int index);
+	/* Runs simulations on the worker until the search is done. */
+	void run_simulations(Worker& worker);
+	void simulate(Worker& worker);
+	int select_child(const Node& node) const;
+	/* Generates the children of a node whose board is play_field, with
+		their priors. Returns false if the piece has nowhere to go. */
+	bool expand(Worker& worker, const PlayField& play_field, const Piece& spawn_piece, std::vector<Node>& children) const;
+
+	MctsOptions options_;
+	Reachability reachability_;
+	Solver evaluator_;
+	NodePool pool_;
+	Stats stats_;
+
+	/* the search in progress */
+	PlayField root_field_;
+	std::vector<Piece> queue_;
+	std::mutex tree_mutex_;
+	/* the highest cost backed up so far, what a virtual loss counts as once
+		has_cost_ is set. Before that it only counts as a visit. */
+	double worst_cost_;
+	bool has_cost_;
+	int max_depth_;
+	long long simulations_;
+	/* 0 if only the clock or the stop flag end the search */
+	long long target_;
+	std::atomic<bool> done_;
+	bool has_deadline_;
+	std::chrono::steady_clock::time_point deadline_;
+	const std::atomic<bool>* stop_;
+
+	/* what the tree can be reused for */
+	bool has_tree_;
+	int chosen_child_;
+	PlayField expected_field_;
+	std::vector<int> expected_types_;
+
+	/* workers_[0] is run by the thread calling find_move, the others by threads_ */
+	std::vector<std::unique_ptr<Worker>> workers_;
+	std::vector<std::thread> threads_;
+	std::mutex pool_mutex_;
+	std::condition_variable work_ready_;
+	std::condition_variable work_done_;
+	/* bumped for every find_move, threads wait for it to change */
+	int generation_;
+	int busy_;
+	bool quit_;
+};
@@ -1,7 +1,23 @@
 #include "Piece.h"
+#include <algorithm>
+#include <stdexcept>
 
 std::array<Piece::Settings, 7U> Piece::settings_;
 
+namespace
+{
+	/* Every type is set up before main runs, after that the tables are
+		only read, so threads can make pieces without racing to set them up. */
+	const bool all_types_set_up = []()
+	{
+		for (int type = 0; type < Piece::type_count; ++type)
+		{
+			Piece::make(type, 0, 0, 0);
+		}
+		return true;
+	}();
+}
+
 /*
  For reference see: http://www.colinfahey.com/tetris/tetris_diagram_pieces_orientations_new.jpg
  */
@@ -16,37 +32,12 @@ Piece::Piece( int rotation, int x, int y, int type)
 
 void Piece::rotate_left()
 {
-	if (settings_[type_].reverse_rotate)
-	{
-		rotation_++;
-	}
-	else
-	{
-		rotation_--;
-	}
-
-	if (rotation_ < 0)
-	{
-		rotation_ = settings_[type_].max_rotations - 1;
-	}
-	rotation_ = rotation_ % settings_[type_].max_rotations;
+	rotation_ = shape().rotated_left;
 }
 
 void Piece::rotate_right()
 {
-	if (settings_[type_].reverse_rotate)
-	{
-		rotation_--;
-	}
-	else
-	{
-		rotation_++;
-	}
-	if (rotation_ < 0)
-	{
-		rotation_ = settings_[type_].max_rotations - 1;
-	}
-	rotation_ = rotation_ % settings_[type_].max_rotations;
+	rotation_ = shape().rotated_right;
 }
 
 void Piece::move(int dx, int dy)
@@ -163,6 +154,7 @@ void Piece::setup_O()
 			} },
 			Color::make_from_bytes(255, 255, 0),
 			1, false, false);
+		setup_shapes(0);
 	}
 }
 
@@ -185,6 +177,7 @@ void Piece::setup_I()
 			} },
 			Color::make_from_bytes(0, 255, 255),
 			2, false, false);
+		setup_shapes(1);
 	}
 }
 
@@ -207,6 +200,7 @@ void Piece::setup_S()
 			} },
 			Color::make_from_bytes(191, 255, 0),
 			2, true, false);
+		setup_shapes(2);
 	}
 }
 
@@ -229,6 +223,7 @@ void Piece::setup_Z()
 				} },
 				Color::make_from_bytes(255, 0, 0),
 				2, true, false);
+		setup_shapes(3);
 	}
 }
 
@@ -251,6 +246,7 @@ void Piece::setup_L()
 				} },
 				Color::make_from_bytes(255, 127, 0),
 				4, false, true);
+		setup_shapes(4);
 	}
 }
 
@@ -273,6 +269,7 @@ void Piece::setup_J()
 				} },
 				Color::make_from_bytes(0, 0, 255),
 				4, false, false);
+		setup_shapes(5);
 	}
 }
 
@@ -295,6 +292,40 @@ void Piece::setup_T()
 				} },
 				Color::make_from_bytes(255, 0, 255),
 				4, false, false);
+		setup_shapes(6);
+	}
+}
+
+void Piece::setup_shapes(int type)
+{
+	Settings& settings = settings_[type];
+	int rotations = settings.max_rotations;
+	for (int rotation = 0; rotation < rotations; ++rotation)
+	{
+		Shape& shape = settings.shapes[rotation];
+		auto tiles = Piece(rotation, 0, 0, type).get_tiles();
+		shape.bottoms.fill(-1);
+		shape.left = PIECE_SIZE;
+		shape.right = -1;
+		for (int y = 0; y < PIECE_SIZE; ++y)
+		{
+			shape.rows[y] = 0;
+			for (int x = 0; x < PIECE_SIZE; ++x)
+			{
+				if (tiles[y * PIECE_SIZE + x] != 0)
+				{
+					shape.rows[y] |= 1 << x;
+					shape.bottoms[x] = y;
+					shape.left = std::min<int8_t>(shape.left, x);
+					shape.right = std::max<int8_t>(shape.right, x);
+				}
+			}
+		}
+
+		/* reverse_rotate pieces count their rotations the other way */
+		int step = settings.reverse_rotate ? -1 : 1;
+		shape.rotated_right = (rotation + step + rotations) % rotations;
+		shape.rotated_left = (rotation - step + rotations) % rotations;
 	}
 }
 
@@ -308,6 +339,26 @@ int Piece::get_max_rotations() const
 	return settings_[type_].max_rotations;
 }
 
+int Piece::get_type() const
+{
+	return type_;
+}
+
+Piece Piece::make(int type, int x, int y, int rotation)
+{
+	switch (type)
+	{
+	case 0: return make_O(x, y, rotation);
+	case 1: return make_I(x, y, rotation);
+	case 2: return make_S(x, y, rotation);
+	case 3: return make_Z(x, y, rotation);
+	case 4: return make_L(x, y, rotation);
+	case 5: return make_J(x, y, rotation);
+	case 6: return make_T(x, y, rotation);
+	default: throw std::out_of_range("No such piece type");
+	}
+}
+
 void Piece::set(int x, int y, int rotation)
 {
 	x_ = x;
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include "Color.h"
+#include <bitset>
+#include <cstdint>
+
+#define PIECE_SIZE 5
+
+class Piece
+{
+public:
+	Piece() {};
+
+	static Piece make_O(int x, int y, int rotation);
+	static Piece make_I(int x, int y, int rotation);
+	static Piece make_S(int x, int y, int rotation);
+	static Piece make_Z(int x, int y, int rotation);
+	static Piece make_L(int x, int y, int rotation);
+	static Piece make_J(int x, int y, int rotation);
+	static Piece make_T(int x, int y, int rotation);
+
+	/* Makes a piece from the id returned by get_type. */
+	static Piece make(int type, int x, int y, int rotation);
+	static const int type_count = 7;
+
+	/*	A piece packed into 16 bits: the type in bits 0-2, the rotation in
+		bits 3-4, x in bits 5-9 and y - top in bits 10-15, top being the y of
+		the field's first row. Pieces rotate around their centre tile and
+		never move up, so every piece a search reaches from the spawn has
+		that tile on the field, and fits for fields up to 32 by 64. */
+	typedef uint16_t Id;
+	Id get_id(int top) const { return static_cast<Id>(type_ | rotation_ << 3 | x_ << 5 | (y_ - top) << 10); }
+	static Piece from_id(Id id, int top) { return Piece((id >> 3) & 3, (id >> 5) & 31, (id >> 10) + top, id & 7); }
+
+	void rotate_left();
+	void rotate_right();
+	void move(int dx, int dy);
+
+	std::array<int, PIECE_SIZE * PIECE_SIZE> get_tiles() const;
+	/* The tiles of get_tiles as one mask per row, bit x set for column x. */
+	const std::array<uint8_t, PIECE_SIZE>& get_rows() const { return shape().rows; }
+	/* For every column of get_tiles, the row of its lowest tile, -1 if it has none. */
+	const std::array<int8_t, PIECE_SIZE>& get_bottoms() const { return shape().bottoms; }
+	/* The x range in which every tile is between the walls of a field width wide. */
+	int get_min_x() const { return 2 - shape().left; }
+	int get_max_x(int width) const { return width + 1 - shape().right; }
+	Color get_color() const;
+	int get_x() const;
+	int get_y() const;
+	int get_rotation() const;
+	int get_max_rotations() const;
+	int get_type() const;
+
+	void set(int x, int y, int rotation);
+private:
+	static void setup_O();
+	static void setup_I();
+	static void setup_S();
+	static void setup_Z();
+	static void setup_L();
+	static void setup_J();
+	static void setup_T();
+	static void setup_shapes(int type);
+
+	Piece(int rotation, int x, int y, int type);
+
+	/*	Everything about one rotation of a piece that the moves and the
+		collision tests need, worked out once from get_tiles so that they
+		only ever index it. Columns and rows are those of get_tiles. */
+	struct Shape
+	{
+		std::array<uint8_t, PIECE_SIZE> rows;
+		std::array<int8_t, PIECE_SIZE> bottoms;
+		/* the first and last column with a tile */
+		int8_t left;
+		int8_t right;
+		/* the rotation rotate_right and rotate_left turn this one into */
+		int8_t rotated_right;
+		int8_t rotated_left;
+	};
+
+	struct Settings
+	{
+		Settings()
+			:setup(false)
+		{}
+
+		Settings(std::array<int, PIECE_SIZE * PIECE_SIZE> tiles_, Color color_, int max_rotations_, bool sz_exception_, bool reverse_rotate_)
+			: color(color_)
+			, max_rotations(max_rotations_)
+			, sz_exception(sz_exception_)
+			, reverse_rotate(reverse_rotate_)
+			, setup(true)
+		{
+			for (int i = 0; i < PIECE_SIZE * PIECE_SIZE; ++i)
+			{
+				tiles[i] = tiles_[i] == 1;
+			}
+		}
+		//These can easily be feather weighted.
+		std::bitset<PIECE_SIZE * PIECE_SIZE> tiles;
+		Color color;
+		bool sz_exception;
+		bool reverse_rotate;
+		int max_rotations;
+		bool setup;
+		/* for every rotation up to max_rotations */
+		std::array<Shape, 4> shapes;
+	};
+
+	static std::array<Settings, 7U> settings_;
+
+	const Shape& shape() const { return settings_[type_].shapes[rotation_]; }
+
+	int rotation_, x_, y_, type_;
+
+};
\ No newline at end of file
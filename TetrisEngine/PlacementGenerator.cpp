@@ -0,0 +1,216 @@
+#include "PlacementGenerator.h"
+#include "Profiler.h"
+#include "State.h"
+#include <algorithm>
+
+PlacementGenerator::PlacementGenerator(const Reachability& reachability)
+	: reachability_(reachability)
+	, w_(0)
+	, h_(0)
+	, top_(0)
+	, spawn_index_(-1)
+	, nodes_(0)
+	, shortcuts_(true)
+{}
+
+int PlacementGenerator::index_of(const Piece& piece) const
+{
+	int x = piece.get_x();
+	int y = piece.get_y() - top_;
+	if (x < 0 || x >= w_ || y < 0 || y >= h_)
+	{
+		return -1;
+	}
+	return State::index(piece.get_id(top_));
+}
+
+Piece::Id PlacementGenerator::id_at(int index) const
+{
+	return static_cast<Piece::Id>(index << 3 | spawn_piece_.get_type());
+}
+
+Piece PlacementGenerator::piece_at(int index) const
+{
+	return Piece::from_id(id_at(index), top_);
+}
+
+void PlacementGenerator::generate(const PlayField& play_field, const Piece& spawn_piece, std::vector<Piece>& placements)
+{
+	PROFILE_SCOPE(BuildStates);
+	w_ = play_field.get_width();
+	/* the buffer rows are searched like any other */
+	h_ = play_field.get_height() + play_field.get_buffer_rows();
+	top_ = play_field.get_top();
+	spawn_piece_ = spawn_piece;
+	placements.clear();
+	if (h_ > max_rows)
+	{
+		spawn_index_ = -1;
+		return;
+	}
+	states_.resize(State::layer_size(h_));
+	visited_.reset(w_, h_);
+	row_queue_.clear();
+	next_row_queue_.clear();
+
+	spawn_index_ = index_of(spawn_piece);
+	if (spawn_index_ == -1 || play_field.test_collision(spawn_piece))
+	{
+		return;
+	}
+	visit(spawn_index_, spawn_index_, 0);
+	row_queue_.push_back(spawn_index_);
+
+	/* One row at a time, so that every position is first reached with the
+		fewest inputs made on its row, which is what the reachability model
+		limits. Positions dropping into the next row wait in next_row_queue_. */
+	const int open_last = play_field.get_stack_top() - 3;
+	const bool overhangs = play_field.has_open_overhangs();
+	int row = spawn_piece.get_y();
+	size_t last_row_size = 0;
+	size_t head = 0;
+	while (head < row_queue_.size() || !next_row_queue_.empty())
+	{
+		if (head == row_queue_.size())
+		{
+			/*	Above the stack only the walls are in the way of the piece, so
+				once a row reaches no more positions than the row above it,
+				every row down to the stack reaches the same ones with the same
+				inputs. Without a limit on the inputs the first row already
+				reaches all of them. */
+			if (shortcuts_ && (row_queue_.size() == last_row_size || reachability_.unlimited()) && row + 1 <= open_last)
+			{
+				/* nothing to tuck under, so the rest is straight drops */
+				if (!overhangs)
+				{
+					land_straight_drops(play_field, placements);
+					return;
+				}
+				for (int& next : next_row_queue_)
+				{
+					Piece dropped = piece_at(next);
+					dropped.move(0, open_last - dropped.get_y());
+					int target = index_of(dropped);
+					visit(target, State::index(states_[next].predecessor), 0);
+					next = target;
+				}
+			}
+			last_row_size = row_queue_.size();
+			row_queue_.swap(next_row_queue_);
+			next_row_queue_.clear();
+			head = 0;
+		}
+		int index = row_queue_[head++];
+		Piece current = piece_at(index);
+		row = current.get_y();
+		int row_inputs = states_[index].row_inputs;
+		PROFILE_COUNT(StatesExpanded);
+		++nodes_;
+
+		Piece move_left = current;
+		Piece move_right = current;
+		Piece rotate_right = current;
+		Piece move_down = current;
+		move_left.move(-1, 0);
+		move_right.move(1, 0);
+		rotate_right.rotate_right();
+		move_down.move(0, 1);
+
+		if (current.get_max_rotations() != 1)
+		{
+			try_add(play_field, rotate_right, index, row_inputs + 1, row_queue_);
+		}
+		try_add(play_field, move_left, index, row_inputs + 1, row_queue_);
+		try_add(play_field, move_right, index, row_inputs + 1, row_queue_);
+		if (!try_add(play_field, move_down, index, 0, next_row_queue_))
+		{
+			placements.push_back(current);
+		}
+	}
+}
+
+void PlacementGenerator::land_straight_drops(const PlayField& play_field, std::vector<Piece>& placements)
+{
+	for (int next : next_row_queue_)
+	{
+		Piece landed = piece_at(next);
+		landed.move(0, play_field.landing_y(landed) - landed.get_y());
+		int target = index_of(landed);
+		visit(target, State::index(states_[next].predecessor), 0);
+		placements.push_back(landed);
+		PROFILE_COUNT(StatesExpanded);
+		++nodes_;
+	}
+	/* the row by row search finds the highest ones first */
+	std::stable_sort(placements.begin(), placements.end(), [](const Piece& a, const Piece& b)
+	{
+		return a.get_y() < b.get_y();
+	});
+}
+
+bool PlacementGenerator::try_add(const PlayField& play_field, const Piece& piece, int from, int row_inputs, std::vector<int>& queue)
+{
+	if (piece.get_x() < piece.get_min_x() || piece.get_x() > piece.get_max_x(play_field.get_width()) || play_field.test_collision(piece))
+	{
+		return false;
+	}
+	if (!reachability_.allows(row_inputs))
+	{
+		return true;
+	}
+	int index = index_of(piece);
+	if (index != -1 && visit(index, from, row_inputs))
+	{
+		queue.push_back(index);
+	}
+	return true;
+}
+
+bool PlacementGenerator::visit(int index, int from, int row_inputs)
+{
+	if (!visited_.insert(id_at(index)))
+	{
+		return false;
+	}
+	states_[index].predecessor = id_at(from);
+	states_[index].row_inputs = static_cast<uint8_t>(row_inputs);
+	return true;
+}
+
+Recording PlacementGenerator::make_recording(const Piece& placement) const
+{
+	PROFILE_SCOPE(MakeRecording);
+	Recording ret;
+	ret.emplace_front();
+
+	int index = index_of(placement);
+	while (index != -1 && index != spawn_index_ && visited_.contains(id_at(index)))
+	{
+		int prev = State::index(states_[index].predecessor);
+		Piece current_piece = piece_at(index);
+		Piece prev_piece = piece_at(prev);
+
+		//the piece dropped here, anything before was done on the row above
+		for (int y = prev_piece.get_y(); y < current_piece.get_y(); ++y)
+		{
+			ret.emplace_front();
+		}
+		while (current_piece.get_rotation() != prev_piece.get_rotation())
+		{
+			current_piece.rotate_left();
+			ret.front().emplace_front(Action::Rotate);
+		}
+		while (current_piece.get_x() < prev_piece.get_x())
+		{
+			current_piece.move(1, 0);
+			ret.front().emplace_front(Action::Left);
+		}
+		while (current_piece.get_x() > prev_piece.get_x())
+		{
+			current_piece.move(-1, 0);
+			ret.front().emplace_front(Action::Right);
+		}
+		index = prev;
+	}
+	return ret;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Action.h"
+#include "PlayField.h"
+#include "Reachability.h"
+#include "State.h"
+#include "VisitedSet.h"
+#include <vector>
+
+/*	Finds every position a piece can lock in, starting from where it spawned,
+	row by row under the reachability model. Solver::search, BeamSearch and
+	MctsSearch all enumerate placements through it. Keeps its working memory
+	between calls, so one generator per thread is the way to use it. */
+class PlacementGenerator
+{
+public:
+	explicit PlacementGenerator(const Reachability& reachability = Reachability());
+
+	/* the most rows, buffer included, a field can have, see Piece::Id */
+	static const int max_rows = 64;
+
+	/* Replaces placements with every position spawn_piece can lock in on
+		play_field. Empty if the piece collides where it spawned, or if the
+		field has more than max_rows rows. */
+	void generate(const PlayField& play_field, const Piece& spawn_piece, std::vector<Piece>& placements);
+
+	/* The inputs that bring the spawn piece of the last generate call to
+		placement, which has to be one of the placements it returned. */
+	Recording make_recording(const Piece& placement) const;
+
+	/* positions expanded since the generator was made */
+	long long get_nodes() const { return nodes_; }
+
+	/* Off, every row is searched instead of dropping over the open rows
+		above the stack and landing straight drops. That finds the same
+		placements, only slower, and is there to check the shortcuts. */
+	void set_shortcuts(bool shortcuts) { shortcuts_ = shortcuts; }
+private:
+	/* State::index of the piece's id, -1 if its centre tile is off the field */
+	int index_of(const Piece& piece) const;
+	Piece::Id id_at(int index) const;
+	Piece piece_at(int index) const;
+	/* Marks the position visited from from, returns false if it already was. */
+	bool visit(int index, int from, int row_inputs);
+	bool try_add(const PlayField& play_field, const Piece& piece, int from, int row_inputs, std::vector<int>& queue);
+	/*	Adds where everything in next_row_queue_ lands when dropped straight
+		down, for a board without open overhangs, where the stack can only
+		stop a falling piece and never lets it reach anything new. They come
+		out in the order the row by row search would have found them. */
+	void land_straight_drops(const PlayField& play_field, std::vector<Piece>& placements);
+
+	Reachability reachability_;
+	/* h_ counts the buffer rows too, top_ is the row index of the first one */
+	int w_, h_, top_;
+	Piece spawn_piece_;
+	VisitedSet visited_;
+	/* indexed like index_of, only set once visited */
+	std::vector<State> states_;
+	std::vector<int> row_queue_;
+	std::vector<int> next_row_queue_;
+	int spawn_index_;
+	long long nodes_;
+	bool shortcuts_;
+};
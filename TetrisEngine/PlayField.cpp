@@ -0,0 +1,328 @@
+#include "PlayField.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+	typedef PlayField::Row Row;
+
+	Row full_row(int width)
+	{
+		return width == 32 ? ~Row(0) : (Row(1) << width) - 1;
+	}
+
+	/*	W and H are 0 for the version that takes the size at run time. For the
+		others the size is a constant, so the loops over rows unroll and the
+		masks are folded in. Piece rows are placed with column c at bit c + 8,
+		so a piece hanging over the left edge never needs a negative shift. */
+	template <int W, int H>
+	struct FieldKernels
+	{
+		static bool test_collision(const Row* rows, int w, int h, const Piece& piece)
+		{
+			const int width = W != 0 ? W : w;
+			const int height = H != 0 ? H : h;
+			/* the walls, checked once from the piece's extents */
+			if (piece.get_x() < piece.get_min_x() || piece.get_x() > piece.get_max_x(width))
+			{
+				return true;
+			}
+			const int shift = piece.get_x() - 2 + 8;
+			const auto& piece_rows = piece.get_rows();
+			for (int j = 0; j < PIECE_SIZE; ++j)
+			{
+				if (piece_rows[j] == 0)
+				{
+					continue;
+				}
+				int y = piece.get_y() + j - 2;
+				if (y >= height)
+				{
+					return true;
+				}
+				if (y >= 0 && (static_cast<Row>((static_cast<uint64_t>(piece_rows[j]) << shift) >> 8) & rows[y]) != 0)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		static bool imprint(Row* rows, int w, int h, const Piece& piece)
+		{
+			const int width = W != 0 ? W : w;
+			const int height = H != 0 ? H : h;
+			const uint64_t inside = static_cast<uint64_t>(full_row(width)) << 8;
+			const int shift = piece.get_x() - 2 + 8;
+			if (shift < 0 || shift > 64 - PIECE_SIZE)
+			{
+				return true;
+			}
+			const auto& piece_rows = piece.get_rows();
+			Row cells[PIECE_SIZE];
+			for (int j = 0; j < PIECE_SIZE; ++j)
+			{
+				cells[j] = static_cast<Row>(((static_cast<uint64_t>(piece_rows[j]) << shift) & inside) >> 8);
+				/* a tile above the field means the game is lost */
+				if (cells[j] != 0 && piece.get_y() + j - 2 < 0)
+				{
+					return false;
+				}
+			}
+			for (int j = 0; j < PIECE_SIZE; ++j)
+			{
+				int y = piece.get_y() + j - 2;
+				if (y >= 0 && y < height)
+				{
+					rows[y] |= cells[j];
+				}
+			}
+			return true;
+		}
+
+		static int clear_rows(Row* rows, int w, int h, int first, int last, uint64_t& cleared_mask)
+		{
+			const int width = W != 0 ? W : w;
+			const int height = H != 0 ? H : h;
+			const Row full = full_row(width);
+			first = first < 0 ? 0 : first;
+			last = last >= height ? height - 1 : last;
+
+			/* the row mask of the clear, nothing moves if it is empty */
+			cleared_mask = 0;
+			int lowest = -1;
+			for (int row = first; row <= last; ++row)
+			{
+				if (rows[row] == full)
+				{
+					cleared_mask |= row < 64 ? uint64_t(1) << row : 0;
+					lowest = row;
+				}
+			}
+			if (lowest == -1)
+			{
+				return 0;
+			}
+
+			/* one pass up from the lowest full row, every kept row is copied
+				straight to where it ends up */
+			int write = lowest;
+			for (int read = lowest; read >= 0; --read)
+			{
+				if (read >= first && rows[read] == full)
+				{
+					continue;
+				}
+				rows[write--] = rows[read];
+			}
+			int cleared = write + 1;
+			while (write >= 0)
+			{
+				rows[write--] = 0;
+			}
+			return cleared;
+		}
+	};
+}
+
+const PlayField::Kernels& PlayField::kernels_for(int w, int h)
+{
+#define PLAYFIELD_KERNELS(W, H) { &FieldKernels<W, H>::test_collision, &FieldKernels<W, H>::imprint, &FieldKernels<W, H>::clear_rows }
+	static const Kernels any_size = PLAYFIELD_KERNELS(0, 0);
+	static const Kernels standard = PLAYFIELD_KERNELS(10, 20);
+	static const Kernels buffered = PLAYFIELD_KERNELS(10, 40);
+	static const Kernels small = PLAYFIELD_KERNELS(6, 12);
+#undef PLAYFIELD_KERNELS
+
+	if (w == 10 && h == 20)
+	{
+		return standard;
+	}
+	if (w == 10 && h == 40)
+	{
+		return buffered;
+	}
+	if (w == 6 && h == 12)
+	{
+		return small;
+	}
+	return any_size;
+}
+
+PlayField::PlayField(int w, int h, int buffer_rows)
+	: rows_(h + buffer_rows > 0 ? h + buffer_rows : 0, 0)
+	, kernels_(&kernels_for(w, h + buffer_rows))
+	, cleared_rows_(0)
+	, last_cleared_(0)
+	, last_cleared_mask_(0)
+	, w_(w)
+	, h_(h)
+	, buffer_rows_(buffer_rows)
+{
+	if (w > max_width)
+	{
+		throw std::invalid_argument("PlayField can be at most 32 tiles wide");
+	}
+	column_tops_.fill(static_cast<int16_t>(rows_.size()));
+}
+
+void PlayField::set(int x, int y, bool occupied)
+{
+	if (x >= 0 && x < w_ && y >= -buffer_rows_ && y < h_)
+	{
+		Row& row = rows_[y + buffer_rows_];
+		if (occupied)
+		{
+			row |= Row(1) << x;
+			column_tops_[x] = std::min(column_tops_[x], static_cast<int16_t>(y + buffer_rows_));
+		}
+		else
+		{
+			row &= ~(Row(1) << x);
+			if (column_tops_[x] == y + buffer_rows_)
+			{
+				update_column_tops();
+			}
+		}
+	}
+}
+
+bool PlayField::get(int x, int y) const
+{
+	if (x >= 0 && x < w_ && y >= -buffer_rows_ && y < h_)
+	{
+		return (rows_[y + buffer_rows_] >> x) & 1;
+	}
+	return false;
+}
+
+bool PlayField::test_collision(const Piece& piece) const
+{
+	PROFILE_COUNT(CollisionsTested);
+	if (buffer_rows_ == 0)
+	{
+		return kernels_->test_collision(rows_.data(), w_, h_, piece);
+	}
+	Piece in_rows = piece;
+	in_rows.move(0, buffer_rows_);
+	return kernels_->test_collision(rows_.data(), w_, h_ + buffer_rows_, in_rows);
+}
+
+bool PlayField::imprint(const Piece& piece)
+{
+	Piece in_rows = piece;
+	in_rows.move(0, buffer_rows_);
+	if (!kernels_->imprint(rows_.data(), w_, h_ + buffer_rows_, in_rows))
+	{
+		return false;
+	}
+	/* only the rows the piece went into can have filled up */
+	last_cleared_ = kernels_->clear_rows(rows_.data(), w_, h_ + buffer_rows_, in_rows.get_y() - 2, in_rows.get_y() + 2, last_cleared_mask_);
+	cleared_rows_ += last_cleared_;
+	if (last_cleared_ > 0)
+	{
+		update_column_tops();
+		return true;
+	}
+
+	/* without a clear only the columns the piece went into can have grown */
+	const auto& piece_rows = in_rows.get_rows();
+	for (int j = 0; j < PIECE_SIZE; ++j)
+	{
+		for (int i = 0; i < PIECE_SIZE; ++i)
+		{
+			int x = in_rows.get_x() + i - 2;
+			if (((piece_rows[j] >> i) & 1) != 0 && x >= 0 && x < w_)
+			{
+				column_tops_[x] = std::min(column_tops_[x], static_cast<int16_t>(in_rows.get_y() + j - 2));
+			}
+		}
+	}
+	return true;
+}
+
+void PlayField::update_column_tops()
+{
+	column_tops_.fill(static_cast<int16_t>(rows_.size()));
+	Row unseen = full_row(w_);
+	for (int y = 0; y < static_cast<int>(rows_.size()) && unseen != 0; ++y)
+	{
+		Row found = rows_[y] & unseen;
+		unseen &= ~found;
+		for (int x = 0; found != 0; ++x, found >>= 1)
+		{
+			if ((found & 1) != 0)
+			{
+				column_tops_[x] = static_cast<int16_t>(y);
+			}
+		}
+	}
+}
+
+int PlayField::get_stack_top() const
+{
+	int top = static_cast<int>(rows_.size());
+	for (int x = 0; x < w_; ++x)
+	{
+		top = std::min(top, static_cast<int>(column_tops_[x]));
+	}
+	return top - buffer_rows_;
+}
+
+uint64_t PlayField::hash() const
+{
+	/* FNV-1a over the rows, a row at a time */
+	uint64_t hash = 14695981039346656037ULL;
+	hash = (hash ^ static_cast<uint64_t>(w_ | h_ << 8 | buffer_rows_ << 16)) * 1099511628211ULL;
+	for (Row row : rows_)
+	{
+		hash = (hash ^ row) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+bool PlayField::has_open_overhangs() const
+{
+	const Row full = full_row(w_);
+	/* the columns without a tile in this row or any above it */
+	Row open = full;
+	for (int y = get_stack_top() + buffer_rows_; y < static_cast<int>(rows_.size()); ++y)
+	{
+		open &= ~rows_[y];
+		Row covered = full & ~open & ~rows_[y];
+		if ((covered & ((open << 1) | (open >> 1))) != 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+int PlayField::landing_y(const Piece& piece) const
+{
+	const int height = static_cast<int>(rows_.size());
+	const auto& bottoms = piece.get_bottoms();
+	int distance = height;
+	for (int i = 0; i < PIECE_SIZE; ++i)
+	{
+		int x = piece.get_x() + i - 2;
+		if (bottoms[i] < 0 || x < 0 || x >= w_)
+		{
+			continue;
+		}
+		int y = piece.get_y() + bottoms[i] - 2 + buffer_rows_;
+		int below = column_tops_[x];
+		/* the column top is above the tile, so it is under an overhang */
+		if (below <= y)
+		{
+			below = y + 1;
+			while (below < height && ((rows_[below] >> x) & 1) == 0)
+			{
+				++below;
+			}
+		}
+		distance = std::min(distance, below - y - 1);
+	}
+	return piece.get_y() + distance;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+/*	A simplistic, less memory-intense version of Board.
+	For use with the Solver
+*/
+
+#include "Piece.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class PlayField
+{
+public:
+	/* bit x is set if the tile in column x is occupied */
+	typedef uint32_t Row;
+	static const int max_width = 32;
+
+	/*	w can be at most max_width. The h visible rows are 0 to h - 1, the
+		buffer rows are hidden above them at -buffer_rows to -1. Pieces may
+		lock in the buffer, only locking above it loses the game. */
+	PlayField(int w, int h, int buffer_rows = 0);
+	void set(int x, int y, bool occupied);
+	bool get(int x, int y) const;
+	Row get_row(int y) const { return rows_[y + buffer_rows_]; }
+
+	bool test_collision(const Piece& piece) const;
+
+	/* This returns true if the piece was imprintable.
+	 * If this returns false, but test_collision returns true
+	 * this means the player has lost the game.
+	 */
+	bool imprint(const Piece& piece);
+
+	int get_width() const { return w_; }
+	int get_height() const { return h_; }
+	int get_buffer_rows() const { return buffer_rows_; }
+	/* The topmost row, 0 unless there are buffer rows. */
+	int get_top() const { return -buffer_rows_; }
+	/* Where pieces spawn: two rows into the buffer, so that they start out
+		above the visible field, or on the top row without a buffer. */
+	int get_spawn_y() const { return buffer_rows_ < 2 ? -buffer_rows_ : -2; }
+	int get_cleared_rows() const { return cleared_rows_; };
+	/* Rows cleared by the last imprint, and which they were: bit
+		y + get_buffer_rows() for row y, rows past the 64th are not in it. */
+	int get_last_cleared() const { return last_cleared_; }
+	uint64_t get_last_cleared_mask() const { return last_cleared_mask_; }
+
+	/* The topmost occupied row of column x, get_height() if it is empty. */
+	int get_column_top(int x) const { return column_tops_[x] - buffer_rows_; }
+	/* The topmost occupied row of any column, get_height() if the field is empty. */
+	int get_stack_top() const;
+	/* The y the piece ends up at when dropped straight down, it must not be
+		colliding where it is. Only the column tops under its lowest tiles are
+		read, unless the piece is tucked under an overhang. */
+	int landing_y(const Piece& piece) const;
+	/*	True if an empty tile under an overhang has open space next to it,
+		open meaning nothing is above it in its column. Without one, every
+		placement a piece can reach is a straight drop from above the stack:
+		pieces rotate around a tile they keep, so they can only get under an
+		overhang by moving in from the side, never into a closed off hole. */
+	bool has_open_overhangs() const;
+
+	/* Hashes what operator== compares. */
+	uint64_t hash() const;
+
+	/* True if both have the same size and tiles, cleared rows are not compared. */
+	bool operator==(const PlayField& other) const
+	{
+		return w_ == other.w_ && h_ == other.h_ && buffer_rows_ == other.buffer_rows_ && rows_ == other.rows_;
+	}
+
+private:
+	/*	The loops over rows, compiled once per supported board size so that
+		they unroll, and once for any other size. They see the buffer and
+		the visible rows as one field, with the buffer's top row at 0. */
+	struct Kernels
+	{
+		bool (*test_collision)(const Row* rows, int w, int h, const Piece& piece);
+		bool (*imprint)(Row* rows, int w, int h, const Piece& piece);
+		/* Clears the full rows among first to last and moves the rest down.
+			Returns how many there were, cleared_mask gets a bit per row. */
+		int (*clear_rows)(Row* rows, int w, int h, int first, int last, uint64_t& cleared_mask);
+	};
+	static const Kernels& kernels_for(int w, int h);
+	void update_column_tops();
+
+	std::vector<Row> rows_;
+	/* in the kernels' row numbering, where h + buffer rows means empty */
+	std::array<int16_t, max_width> column_tops_;
+	const Kernels* kernels_;
+	int cleared_rows_;
+	int last_cleared_;
+	uint64_t last_cleared_mask_;
+	int w_, h_;
+	int buffer_rows_;
+};
@@ -0,0 +1,109 @@
+#include "Profiler.h"
+
+#ifdef TETRIS_PROFILE
+
+Profiler& Profiler::get()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+Profiler::Profiler()
+{
+	for (auto& counter : current_counters_)
+	{
+		counter = 0;
+	}
+	for (auto& time : current_nanoseconds_)
+	{
+		time = 0;
+	}
+}
+
+void Profiler::end_piece()
+{
+	Sample sample;
+	for (int i = 0; i < CounterCount; ++i)
+	{
+		sample.counters[i] = current_counters_[i].exchange(0);
+	}
+	for (int i = 0; i < PhaseCount; ++i)
+	{
+		sample.nanoseconds[i] = current_nanoseconds_[i].exchange(0);
+	}
+	samples_.push_back(sample);
+}
+
+const char* Profiler::counter_name(Counter counter)
+{
+	switch (counter)
+	{
+	case StatesExpanded: return "states_expanded";
+	case CollisionsTested: return "collisions_tested";
+	case LeavesEvaluated: return "leaves_evaluated";
+	case PlayFieldCopies: return "play_field_copies";
+	case Allocations: return "allocations";
+	default: return "unknown";
+	}
+}
+
+const char* Profiler::phase_name(Phase phase)
+{
+	switch (phase)
+	{
+	case BuildStates: return "build_states_ns";
+	case Search: return "search_ns";
+	case Evaluate: return "evaluate_ns";
+	case MakeRecording: return "make_recording_ns";
+	default: return "unknown";
+	}
+}
+
+void Profiler::write_csv(std::ostream& out) const
+{
+	out << "piece";
+	for (int i = 0; i < CounterCount; ++i)
+	{
+		out << "," << counter_name(static_cast<Counter>(i));
+	}
+	for (int i = 0; i < PhaseCount; ++i)
+	{
+		out << "," << phase_name(static_cast<Phase>(i));
+	}
+	out << "\n";
+
+	for (size_t piece = 0; piece < samples_.size(); ++piece)
+	{
+		out << piece;
+		for (auto counter : samples_[piece].counters)
+		{
+			out << "," << counter;
+		}
+		for (auto time : samples_[piece].nanoseconds)
+		{
+			out << "," << time;
+		}
+		out << "\n";
+	}
+}
+
+void Profiler::write_json(std::ostream& out) const
+{
+	out << "[\n";
+	for (size_t piece = 0; piece < samples_.size(); ++piece)
+	{
+		out << "  {\"piece\": " << piece;
+		for (int i = 0; i < CounterCount; ++i)
+		{
+			out << ", \"" << counter_name(static_cast<Counter>(i)) << "\": " << samples_[piece].counters[i];
+		}
+		for (int i = 0; i < PhaseCount; ++i)
+		{
+			out << ", \"" << phase_name(static_cast<Phase>(i)) << "\": " << samples_[piece].nanoseconds[i];
+		}
+		out << (piece + 1 < samples_.size() ? "},\n" : "}\n");
+	}
+	out << "]\n";
+}
+
+#endif
@@ -0,0 +1,106 @@
+#pragma once
+
+/*	Instrumentation for the Solver.
+ *	Define TETRIS_PROFILE to count what the search does and time each of its
+ *	phases. Everything is aggregated per searched piece and can be written as
+ *	CSV or JSON once the game is over.
+ *
+ *	Without TETRIS_PROFILE the PROFILE_* macros expand to nothing, so the
+ *	instrumented code is exactly the code that would be there without them.
+ */
+
+#ifdef TETRIS_PROFILE
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+class Profiler
+{
+public:
+	enum Counter { StatesExpanded, CollisionsTested, LeavesEvaluated, PlayFieldCopies, Allocations, CounterCount };
+	/*	BuildStates times PlacementGenerator::generate and MakeRecording its
+		make_recording, for every engine. Phases nest, Search includes the
+		generating and evaluating done under it. */
+	enum Phase { BuildStates, Search, Evaluate, MakeRecording, PhaseCount };
+
+	struct Sample
+	{
+		Sample()
+		{
+			counters.fill(0);
+			nanoseconds.fill(0);
+		}
+
+		std::array<uint64_t, CounterCount> counters;
+		std::array<uint64_t, PhaseCount> nanoseconds;
+	};
+
+	class ScopedTimer
+	{
+	public:
+		ScopedTimer(Phase phase)
+			: phase_(phase)
+			, start_(std::chrono::steady_clock::now())
+		{}
+
+		~ScopedTimer()
+		{
+			auto elapsed = std::chrono::steady_clock::now() - start_;
+			Profiler::get().add_time(phase_, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+		}
+
+		ScopedTimer(const ScopedTimer&) = delete;
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+	private:
+		Phase phase_;
+		std::chrono::steady_clock::time_point start_;
+	};
+
+	static Profiler& get();
+
+	void count(Counter counter)
+	{
+		current_counters_[counter].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void add_time(Phase phase, uint64_t nanoseconds)
+	{
+		current_nanoseconds_[phase].fetch_add(nanoseconds, std::memory_order_relaxed);
+	}
+
+	/* Closes the sample of the piece that was just searched and starts a new one. */
+	void end_piece();
+
+	const std::vector<Sample>& get_samples() const { return samples_; }
+
+	void write_csv(std::ostream& out) const;
+	void write_json(std::ostream& out) const;
+
+	static const char* counter_name(Counter counter);
+	static const char* phase_name(Phase phase);
+private:
+	Profiler();
+
+	std::array<std::atomic<uint64_t>, CounterCount> current_counters_;
+	std::array<std::atomic<uint64_t>, PhaseCount> current_nanoseconds_;
+	std::vector<Sample> samples_;
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#define PROFILE_COUNT(counter) Profiler::get().count(Profiler::counter)
+#define PROFILE_SCOPE(phase) Profiler::ScopedTimer PROFILE_CONCAT(profile_timer_, __LINE__)(Profiler::phase)
+#define PROFILE_END_PIECE() Profiler::get().end_piece()
+
+#else
+
+#define PROFILE_COUNT(counter) ((void)0)
+#define PROFILE_SCOPE(phase) ((void)0)
+#define PROFILE_END_PIECE() ((void)0)
+
+#endif
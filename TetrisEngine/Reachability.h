@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cmath>
+
+/*	Describes how many inputs the player can make before gravity
+ *	pulls the piece down one row. The search uses this to only consider
+ *	placements that are physically reachable at the current speed.
+ *
+ *	A frames_per_row of 0 means there is no gravity limit, ie: the piece
+ *	can be moved and rotated any number of times on every row.
+ */
+struct Reachability
+{
+	Reachability()
+		: frames_per_row(0.0)
+		, inputs_per_frame(1.0)
+	{}
+
+	Reachability(double frames_per_row_, double inputs_per_frame_)
+		: frames_per_row(frames_per_row_)
+		, inputs_per_frame(inputs_per_frame_)
+	{}
+
+	bool unlimited() const
+	{
+		return frames_per_row <= 0.0;
+	}
+
+	/* Number of moves and rotations that fit before the next drop. */
+	int inputs_per_row() const
+	{
+		return static_cast<int>(std::floor(frames_per_row * inputs_per_frame));
+	}
+
+	/* True if a piece that has made this many inputs on its current row
+		could still have made them before dropping. */
+	bool allows(int row_inputs) const
+	{
+		return unlimited() || row_inputs <= inputs_per_row();
+	}
+
+	double frames_per_row;
+	double inputs_per_frame;
+};
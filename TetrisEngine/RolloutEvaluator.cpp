@@ -0,0 +1,309 @@
+#include "RolloutEvaluator.h"
+#include "EvaluationFunctions.h"
+#include "Trace.h"
+#include <algorithm>
+#include <bitset>
+#include <limits>
+#include <random>
+
+namespace
+{
+	/* EvaluationFunction<0> per number of lines cleared */
+	const double line_values[] = { -1.0, 0.5, 1.5, 4.0, 8.0 };
+	/* worse than any board that is still in play */
+	const double topped_out_cost = 10000.0;
+
+	double line_cost(int lines)
+	{
+		return line_values[std::min(lines, 4)] * EvaluationFunction<0>::weight();
+	}
+
+	int count_bits(uint32_t bits)
+	{
+		return static_cast<int>(std::bitset<32>(bits).count());
+	}
+}
+
+RolloutEvaluator::RolloutEvaluator(const RolloutOptions& options)
+	: options_(options)
+	, w_(0)
+	, h_(0)
+	, full_row_(0)
+	, rollouts_run_(0)
+	, generation_(0)
+	, busy_(0)
+	, quit_(false)
+{
+	setup_shapes();
+	std::uniform_int_distribution<int> random_type(0, Piece::type_count - 1);
+	for (int i = 0; i < options_.rollouts; ++i)
+	{
+		std::seed_seq seed{ options_.seed, static_cast<unsigned int>(i) };
+		std::mt19937 random(seed);
+		types_.emplace_back();
+		for (int piece = 0; piece < options_.pieces; ++piece)
+		{
+			types_.back().push_back(random_type(random));
+		}
+	}
+	costs_.resize(types_.size());
+
+	int threads = options_.threads > 0 ? options_.threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+	workers_.resize(threads);
+	/* the calling thread is worker 0 */
+	for (int t = 1; t < threads; ++t)
+	{
+		threads_.emplace_back(&RolloutEvaluator::work, this, t);
+	}
+}
+
+RolloutEvaluator::~RolloutEvaluator()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		quit_ = true;
+	}
+	work_ready_.notify_all();
+	for (auto& thread : threads_)
+	{
+		thread.join();
+	}
+}
+
+Solver::LeafEvaluator RolloutEvaluator::leaf_evaluator()
+{
+	return [this](const PlayField& from, const PlayField& to, const std::vector<Piece>& locked_pieces)
+	{
+		return evaluate(from, to, locked_pieces);
+	};
+}
+
+void RolloutEvaluator::setup_shapes()
+{
+	shapes_.resize(Piece::type_count);
+	for (int type = 0; type < Piece::type_count; ++type)
+	{
+		int rotations = Piece::make(type, 0, 0, 0).get_max_rotations();
+		for (int rotation = 0; rotation < rotations; ++rotation)
+		{
+			auto tiles = Piece::make(type, 0, 0, rotation).get_tiles();
+			int min_x = PIECE_SIZE, max_x = -1, min_y = PIECE_SIZE, max_y = -1;
+			for (int y = 0; y < PIECE_SIZE; ++y)
+			{
+				for (int x = 0; x < PIECE_SIZE; ++x)
+				{
+					if (tiles[y * PIECE_SIZE + x] != 0)
+					{
+						min_x = std::min(min_x, x);
+						max_x = std::max(max_x, x);
+						min_y = std::min(min_y, y);
+						max_y = std::max(max_y, y);
+					}
+				}
+			}
+
+			Shape shape = {};
+			shape.width = max_x - min_x + 1;
+			shape.height = max_y - min_y + 1;
+			for (int y = min_y; y <= max_y; ++y)
+			{
+				for (int x = min_x; x <= max_x; ++x)
+				{
+					if (tiles[y * PIECE_SIZE + x] != 0)
+					{
+						shape.rows[y - min_y] |= 1u << (x - min_x);
+					}
+				}
+			}
+			shapes_[type].push_back(shape);
+		}
+	}
+}
+
+double RolloutEvaluator::evaluate(const PlayField& from, const PlayField& to, const std::vector<Piece>& locked_pieces)
+{
+	TRACE_SCOPE("RolloutEvaluator::evaluate");
+	double value = static_evaluator_.evaluate(from, to, locked_pieces);
+	/* the row masks have room for 32 columns */
+	if (to.get_width() > 32 || options_.rollouts <= 0)
+	{
+		return value;
+	}
+
+	std::lock_guard<std::mutex> call_lock(call_mutex_);
+	w_ = to.get_width();
+	h_ = to.get_height() + to.get_buffer_rows();
+	full_row_ = w_ == 32 ? 0xffffffffu : (1u << w_) - 1;
+	start_rows_.assign(h_, 0);
+	for (int y = 0; y < h_; ++y)
+	{
+		for (int x = 0; x < w_; ++x)
+		{
+			if (to.get(x, y + to.get_top()))
+			{
+				start_rows_[y] |= 1u << x;
+			}
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		busy_ = static_cast<int>(threads_.size());
+		++generation_;
+	}
+	work_ready_.notify_all();
+	run_playouts(0);
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		work_done_.wait(lock, [this]() { return busy_ == 0; });
+	}
+
+	/* summed in index order, the same whichever thread played what */
+	double cost = 0.0;
+	for (double playout_cost : costs_)
+	{
+		cost += playout_cost;
+	}
+	rollouts_run_ += options_.rollouts;
+	return value + cost / options_.rollouts;
+}
+
+void RolloutEvaluator::work(int index)
+{
+	int seen = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			work_ready_.wait(lock, [&]() { return quit_ || generation_ != seen; });
+			if (quit_)
+			{
+				return;
+			}
+			seen = generation_;
+		}
+		run_playouts(index);
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			--busy_;
+		}
+		work_done_.notify_one();
+	}
+}
+
+void RolloutEvaluator::run_playouts(int index)
+{
+	int threads = static_cast<int>(workers_.size());
+	int first = options_.rollouts * index / threads;
+	int last = options_.rollouts * (index + 1) / threads;
+	for (int i = first; i < last; ++i)
+	{
+		costs_[i] = playout(workers_[index], types_[i]);
+	}
+}
+
+double RolloutEvaluator::playout(Worker& worker, const std::vector<int>& types)
+{
+	worker.rows = start_rows_;
+	double cost = 0.0;
+	for (int piece = 0; piece < options_.pieces; ++piece)
+	{
+		double best = std::numeric_limits<double>::max();
+		int best_lines = 0;
+		for (auto& shape : shapes_[types[piece]])
+		{
+			for (int x = 0; x + shape.width <= w_; ++x)
+			{
+				int lines;
+				if (!drop(worker.rows, shape, x, worker.next_rows, lines))
+				{
+					continue;
+				}
+				double value = board_cost(worker.next_rows) + line_cost(lines);
+				if (value < best)
+				{
+					best = value;
+					best_lines = lines;
+					std::swap(worker.best_rows, worker.next_rows);
+				}
+			}
+		}
+		if (best == std::numeric_limits<double>::max())
+		{
+			return cost + topped_out_cost;
+		}
+		std::swap(worker.rows, worker.best_rows);
+		cost += line_cost(best_lines);
+	}
+	return cost + board_cost(worker.rows);
+}
+
+bool RolloutEvaluator::drop(const Rows& rows, const Shape& shape, int x, Rows& result, int& lines) const
+{
+	auto fits = [&](int y)
+	{
+		for (int i = 0; i < shape.height; ++i)
+		{
+			if (rows[y + i] & (shape.rows[i] << x))
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+	if (shape.height > h_ || !fits(0))
+	{
+		return false;
+	}
+	int y = 0;
+	while (y + shape.height < h_ && fits(y + 1))
+	{
+		++y;
+	}
+
+	result = rows;
+	for (int i = 0; i < shape.height; ++i)
+	{
+		result[y + i] |= shape.rows[i] << x;
+	}
+
+	/* full rows are dropped by moving the rows above them down */
+	lines = 0;
+	int write = h_ - 1;
+	for (int read = h_ - 1; read >= 0; --read)
+	{
+		if (result[read] == full_row_)
+		{
+			++lines;
+			continue;
+		}
+		result[write--] = result[read];
+	}
+	while (write >= 0)
+	{
+		result[write--] = 0;
+	}
+	return true;
+}
+
+double RolloutEvaluator::board_cost(const Rows& rows) const
+{
+	/* the holes, column transitions and pile height of EvaluationFunctions.h
+		over the same rows, a row at a time. Lock height, well cells and row
+		transitions are left to the static score of the leaf. */
+	int holes = 0;
+	int transitions = 0;
+	int pile_height = 0;
+	for (int y = 1; y < h_; ++y)
+	{
+		transitions += count_bits(~rows[y - 1] & rows[y]);
+		if (y < h_ - 1)
+		{
+			holes += count_bits(rows[y - 1] & ~rows[y]);
+			pile_height += rows[y] != 0 ? 1 : 0;
+		}
+	}
+	return holes * EvaluationFunction<3>::weight()
+		+ transitions * EvaluationFunction<4>::weight()
+		+ pile_height * EvaluationFunction<6>::weight();
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+/*	Scores a leaf of the search by playing on from it. Every playout draws
+	random pieces and drops each where a cheap one ply heuristic likes it
+	best, the leaf is then scored by how the boards it led to looked on
+	average. Boards are kept as one bit mask per row so a playout never
+	touches a PlayField. The pieces of each playout only depend on the seed
+	and its index, so every leaf is played on with the same pieces, and the
+	scores do not depend on the number of threads or their timing. */
+
+#include "Solver.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct RolloutOptions
+{
+	RolloutOptions()
+		: rollouts(32), pieces(4), threads(0), seed(1)
+	{}
+
+	/* playouts run for every position scored */
+	int rollouts;
+	/* pieces dropped in each playout */
+	int pieces;
+	/* threads running the playouts, 0 uses one per core */
+	int threads;
+	unsigned int seed;
+};
+
+class RolloutEvaluator
+{
+public:
+	explicit RolloutEvaluator(const RolloutOptions& options);
+	~RolloutEvaluator();
+
+	/*	Same contract as Solver::evaluate, lower is better. The static score
+		of the leaf plus the average cost of the playouts from it. One call
+		runs at a time, the playouts of a call are spread over the threads. */
+	double evaluate(const PlayField& from, const PlayField& to, const std::vector<Piece>& locked_pieces);
+
+	/* A leaf evaluator for Solver::set_leaf_evaluator that calls this one. */
+	Solver::LeafEvaluator leaf_evaluator();
+
+	/* playouts run since the evaluator was made */
+	long long get_rollouts() const { return rollouts_run_; }
+private:
+	typedef std::vector<uint32_t> Rows;
+
+	/* A piece in one rotation, as row masks with its leftmost tile in bit 0. */
+	struct Shape
+	{
+		uint32_t rows[4];
+		int width, height;
+	};
+
+	struct Worker
+	{
+		Rows rows, next_rows, best_rows;
+	};
+
+	void setup_shapes();
+	void work(int index);
+	/* Plays the worker's share of the playouts, a fixed range of indices. */
+	void run_playouts(int index);
+	double playout(Worker& worker, const std::vector<int>& types);
+	/* Drops shape at column x, false if it does not fit at the top. */
+	bool drop(const Rows& rows, const Shape& shape, int x, Rows& result, int& lines) const;
+	double board_cost(const Rows& rows) const;
+
+	RolloutOptions options_;
+	Solver static_evaluator_;
+	std::vector<std::vector<Shape>> shapes_;
+	int w_, h_;
+	uint32_t full_row_;
+	Rows start_rows_;
+	/* the pieces of each playout, and what it cost in the current call */
+	std::vector<std::vector<int>> types_;
+	std::vector<double> costs_;
+	long long rollouts_run_;
+
+	std::vector<Worker> workers_;
+	std::vector<std::thread> threads_;
+	std::mutex call_mutex_;
+	std::mutex mutex_;
+	std::condition_variable work_ready_;
+	std::condition_variable work_done_;
+	/* bumped for every call, workers wait for it to change */
+	int generation_;
+	int busy_;
+	bool quit_;
+};
@@ -0,0 +1,370 @@
+#include "Solver.h"
+#include "EvaluationFunctions.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+	bool same_piece(const Piece& a, const Piece& b)
+	{
+		return a.get_type() == b.get_type()
+			&& a.get_x() == b.get_x()
+			&& a.get_y() == b.get_y()
+			&& a.get_rotation() == b.get_rotation();
+	}
+
+	uint64_t cache_key(const PlayField& play_field, const Piece& piece, int lines)
+	{
+		uint64_t key = static_cast<uint64_t>(piece.get_id(play_field.get_top())) << 8 | static_cast<uint8_t>(lines);
+		return play_field.hash() ^ key * 0x9e3779b97f4a7c15ull;
+	}
+}
+
+Solver::Solver()
+	: searches_(0)
+	, branch_(-1)
+	, cache_leaves_(false)
+	, reused_(0)
+	, has_principal_child_(false)
+	, nodes_(0)
+	, duplicates_(0)
+	, polls_(0)
+	, has_deadline_(false)
+	, has_fallback_(false)
+	, aborted_(false)
+	, stop_(nullptr)
+{
+	evaluations_.emplace_back(EvaluationFunction<0>(), EvaluationFunction<0>::weight());
+	evaluations_.emplace_back(EvaluationFunction<1>(), EvaluationFunction<1>::weight());
+	evaluations_.emplace_back(EvaluationFunction<2>(), EvaluationFunction<2>::weight());
+	evaluations_.emplace_back(EvaluationFunction<3>(), EvaluationFunction<3>::weight());
+	evaluations_.emplace_back(EvaluationFunction<4>(), EvaluationFunction<4>::weight());
+	evaluations_.emplace_back(EvaluationFunction<5>(), EvaluationFunction<5>::weight());
+	evaluations_.emplace_back(EvaluationFunction<6>(), EvaluationFunction<6>::weight());
+}
+
+void Solver::set_reachability(const Reachability& reachability)
+{
+	reachability_ = reachability;
+	/* the generators were made with the old one, and so were the placement lists */
+	layers_.clear();
+	expansions_.clear();
+}
+
+void Solver::set_leaf_evaluator(const LeafEvaluator& leaf_evaluator)
+{
+	leaf_evaluator_ = leaf_evaluator;
+	leaves_.clear();
+}
+
+Solver::Move Solver::find_move(const PlayField& play_field, const std::vector<Piece>& piece_queue, int time_budget_ms, const std::atomic<bool>* stop)
+{
+	Move move;
+	nodes_ = 0;
+	duplicates_ = 0;
+	reused_ = 0;
+	++searches_;
+	aborted_ = false;
+	has_fallback_ = false;
+	has_deadline_ = time_budget_ms > 0;
+	deadline_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(time_budget_ms);
+	stop_ = stop;
+
+	/* the last search already looked at this piece, under the placement that was made */
+	if (subtree_.matches(play_field, piece_queue.front()))
+	{
+		move.found = true;
+		move.placement = subtree_.placement;
+		move.recording = subtree_.recording;
+		move.depth = subtree_.depth;
+		has_fallback_ = true;
+	}
+	subtree_.valid = false;
+
+	prepare_layers(piece_queue);
+
+	size_t first_depth = has_deadline_ || stop != nullptr ? 1 : piece_queue.size();
+	cache_leaves_ = first_depth < piece_queue.size();
+	int best_branch = -1;
+	for (size_t depth = first_depth; depth <= piece_queue.size(); ++depth)
+	{
+		std::vector<Piece> queue(piece_queue.begin(), piece_queue.begin() + depth);
+		PlayField root = play_field;
+		int best;
+		double best_value;
+		has_principal_child_ = false;
+		branch_ = -1;
+		transpositions_.resize(depth);
+		for (auto& transpositions : transpositions_)
+		{
+			transpositions.clear();
+		}
+		{
+			PROFILE_SCOPE(Search);
+			TRACE_SCOPE("Solver::search");
+			best = search(root, root, 0, queue, std::vector<Piece>(), best_value);
+		}
+		if (aborted_ || best == -1)
+		{
+			break;
+		}
+
+		move.found = true;
+		move.placement = layers_[0].placements[best];
+		move.recording = make_recording(0, play_field, piece_queue.front(), move.placement);
+		move.depth = static_cast<int>(depth);
+
+		subtree_.valid = has_principal_child_;
+		if (has_principal_child_)
+		{
+			subtree_.root = play_field;
+			subtree_.root.imprint(move.placement);
+			subtree_.spawn_piece = piece_queue[1];
+			subtree_.placement = principal_child_;
+			subtree_.recording = principal_recording_;
+			subtree_.depth = static_cast<int>(depth) - 1;
+		}
+
+		/* only give up on a depth once there is a move to fall back on */
+		has_fallback_ = true;
+		best_branch = best;
+	}
+	if (!move.found)
+	{
+		move.recording.emplace_back();
+	}
+	keep_branch(best_branch);
+	move.nodes = nodes_;
+	move.duplicates = duplicates_;
+	move.reused = reused_;
+	return move;
+}
+
+bool Solver::out_of_time()
+{
+	if (has_fallback_ && !aborted_ && (++polls_ & 15) == 0)
+	{
+		aborted_ = (stop_ != nullptr && stop_->load(std::memory_order_relaxed))
+			|| (has_deadline_ && std::chrono::steady_clock::now() > deadline_);
+	}
+	return aborted_;
+}
+
+bool Solver::Subtree::matches(const PlayField& play_field, const Piece& piece) const
+{
+	return valid
+		&& piece.get_type() == spawn_piece.get_type()
+		&& piece.get_x() == spawn_piece.get_x()
+		&& piece.get_y() == spawn_piece.get_y()
+		&& piece.get_rotation() == spawn_piece.get_rotation()
+		&& play_field == root;
+}
+
+int Solver::search(PlayField& original_play_field, PlayField& play_field, int depth, const std::vector<Piece>& piece_queue, const std::vector<Piece>& locked_pieces, double& best_value)
+{
+	if (depth == piece_queue.size())
+	{
+		return -1;
+	}
+
+	Layer& layer = layers_[depth];
+	expand(depth, play_field, piece_queue[depth]);
+
+	/* Locks each placement and searches the next piece from there, in the
+		order the generator found them, so that ties go to the first. */
+	int best = -1;
+	for (int i = 0; i < static_cast<int>(layer.placements.size()); ++i)
+	{
+		if (out_of_time())
+		{
+			return -1;
+		}
+		if (depth == 0)
+		{
+			branch_ = i;
+		}
+		const Piece current = layer.placements[i];
+		PlayField next_play_field = play_field;
+		PROFILE_COUNT(PlayFieldCopies);
+		PROFILE_COUNT(Allocations);
+		next_play_field.imprint(current);
+		std::vector<Piece> locked = locked_pieces;
+		locked.push_back(current);
+
+		/* the first depth cannot leave the same board twice, and the last one is not searched below */
+		bool keep = depth > 0 && depth + 1 < static_cast<int>(piece_queue.size());
+		uint64_t hash = keep ? next_play_field.hash() : 0;
+		double value;
+		int next_search = -1;
+		auto seen = keep ? transpositions_[depth].find(hash) : transpositions_[depth].end();
+		if (seen != transpositions_[depth].end() && seen->second.play_field == next_play_field)
+		{
+			++duplicates_;
+			value = seen->second.value;
+		}
+		else
+		{
+			next_search = search(original_play_field, next_play_field, depth + 1, piece_queue, locked, value);
+			if (aborted_)
+			{
+				return -1;
+			}
+			if (next_search == -1 && depth + 1 < static_cast<int>(piece_queue.size()))
+			{
+				/* the next piece has nowhere to go, the game is lost down this branch */
+				value = std::numeric_limits<double>::infinity();
+			}
+			else if (next_search == -1)
+			{
+				value = leaf_evaluator_ ? leaf_evaluator_(original_play_field, next_play_field, locked) : leaf_value(original_play_field, next_play_field, locked);
+			}
+			else if (keep)
+			{
+				transpositions_[depth].emplace(hash, Transposition(next_play_field, value));
+			}
+		}
+		if (best == -1 || best_value > value)
+		{
+			best = i;
+			best_value = value;
+			if (depth == 0)
+			{
+				has_principal_child_ = next_search != -1;
+			}
+			if (depth == 0 && next_search != -1)
+			{
+				/* the layer below is searched again for the next branch, so the path has to be taken now */
+				principal_child_ = layers_[1].placements[next_search];
+				principal_recording_ = make_recording(1, next_play_field, piece_queue[1], principal_child_);
+			}
+		}
+	}
+	return best;
+}
+
+void Solver::prepare_layers(const std::vector<Piece>& piece_queue)
+{
+	TRACE_SCOPE("Solver::prepare_layers");
+	while (layers_.size() < piece_queue.size())
+	{
+		layers_.emplace_back(reachability_);
+	}
+}
+
+void Solver::expand(int depth, const PlayField& play_field, const Piece& spawn_piece)
+{
+	Layer& layer = layers_[depth];
+	uint64_t key = cache_key(play_field, spawn_piece, 0);
+	auto cached = expansions_.find(key);
+	if (cached != expansions_.end() && same_piece(cached->second.spawn_piece, spawn_piece) && cached->second.play_field == play_field)
+	{
+		++reused_;
+		layer.placements = cached->second.placements;
+		layer.generated = false;
+	}
+	else
+	{
+		long long generated = layer.generator.get_nodes();
+		layer.generator.generate(play_field, spawn_piece, layer.placements);
+		nodes_ += layer.generator.get_nodes() - generated;
+		layer.generated = true;
+		if (cached != expansions_.end())
+		{
+			/* another board with the same hash, the newer one is more likely to come up again */
+			cached->second = Expansion(play_field, spawn_piece, layer.placements);
+		}
+		else if (expansions_.size() < max_cached)
+		{
+			cached = expansions_.emplace(key, Expansion(play_field, spawn_piece, layer.placements)).first;
+		}
+	}
+	if (cached != expansions_.end())
+	{
+		cached->second.search = searches_;
+		cached->second.branch = branch_;
+	}
+}
+
+Solver::Recording Solver::make_recording(int depth, const PlayField& play_field, const Piece& spawn_piece, const Piece& placement)
+{
+	Layer& layer = layers_[depth];
+	if (!layer.generated)
+	{
+		/* the recording is made from the paths of the generator's last run */
+		std::vector<Piece> placements;
+		layer.generator.generate(play_field, spawn_piece, placements);
+		layer.generated = true;
+	}
+	return layer.generator.make_recording(placement);
+}
+
+double Solver::leaf_value(const PlayField& from, const PlayField& to, const std::vector<Piece>& locked_pieces)
+{
+	if (!cache_leaves_)
+	{
+		return evaluate_play_field(from, to, locked_pieces);
+	}
+	const Piece& last = locked_pieces.back();
+	int lines = to.get_cleared_rows() - from.get_cleared_rows();
+	uint64_t key = cache_key(to, last, lines);
+	auto cached = leaves_.find(key);
+	if (cached != leaves_.end() && cached->second.lines == lines && same_piece(cached->second.last, last) && cached->second.play_field == to)
+	{
+		++reused_;
+	}
+	else
+	{
+		double value = evaluate_play_field(from, to, locked_pieces);
+		if (cached != leaves_.end())
+		{
+			cached->second = Leaf(to, last, lines, value);
+		}
+		else if (leaves_.size() < max_cached)
+		{
+			cached = leaves_.emplace(key, Leaf(to, last, lines, value)).first;
+		}
+		else
+		{
+			return value;
+		}
+	}
+	cached->second.search = searches_;
+	cached->second.branch = branch_;
+	return cached->second.value;
+}
+
+void Solver::keep_branch(int branch)
+{
+	for (auto it = expansions_.begin(); it != expansions_.end();)
+	{
+		it = it->second.search == searches_ && it->second.branch == branch ? std::next(it) : expansions_.erase(it);
+	}
+	for (auto it = leaves_.begin(); it != leaves_.end();)
+	{
+		it = it->second.search == searches_ && it->second.branch == branch ? std::next(it) : leaves_.erase(it);
+	}
+}
+
+double Solver::evaluate(const PlayField& play_field) const
+{
+	return evaluate_play_field(play_field, play_field, std::vector<Piece>());
+}
+
+double Solver::evaluate(const PlayField& from, const PlayField& to, const std::vector<Piece>& locked_pieces) const
+{
+	return evaluate_play_field(from, to, locked_pieces);
+}
+
+double Solver::evaluate_play_field(const PlayField& from, const PlayField& to, const std::vector<Piece>& piece_queue) const
+{
+	PROFILE_SCOPE(Evaluate);
+	PROFILE_COUNT(LeavesEvaluated);
+	double total = 0;
+	for (auto& eval : evaluations_)
+	{
+		total += eval.first(from, to, piece_queue) * eval.second;
+	}
+	return total;
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include "Action.h"
+#include "PlayField.h"
+#include <deque>
+#include <functional>
+#include <vector>
+#include "PlacementGenerator.h"
+#include "Reachability.h"
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+
+class Solver
+{
+public:
+	typedef ::Recording Recording;
+	typedef std::function<double(const PlayField& from, const PlayField& to, const std::vector<Piece>& locked_pieces)> LeafEvaluator;
+
+	/* The outcome of find_move. */
+	struct Move
+	{
+		Move()
+			: found(false), depth(0), nodes(0), duplicates(0), reused(0)
+		{}
+
+		bool found;
+		/* where the first piece of the queue locks */
+		Piece placement;
+		/* the inputs that get it there, one frame per row */
+		Recording recording;
+		/* how many pieces of the queue the chosen move looked at */
+		int depth;
+		long long nodes;
+		/* placements not searched further because another placement at the
+			same depth had already left the same board */
+		long long duplicates;
+		/* placement lists and leaf values taken from an earlier search or
+			deepening step rather than worked out again */
+		long long reused;
+	};
+
+	Solver();
+
+	/*	Finds where to place the first piece of piece_queue on play_field.
+		Pieces must be at their spawn position. With a time budget (in
+		milliseconds) the search deepens one queue piece at a time and keeps
+		the deepest result that finished in time, without one the whole queue
+		is searched. Setting stop from another thread ends the search early in
+		the same way, which also makes it deepen one piece at a time. Fields
+		with more than PlacementGenerator::max_rows rows have no placements,
+		no move is found on them. */
+	Move find_move(const PlayField& play_field, const std::vector<Piece>& piece_queue, int time_budget_ms, const std::atomic<bool>* stop = nullptr);
+
+	/* Limits the search to placements reachable at the given gravity. */
+	void set_reachability(const Reachability& reachability);
+
+	/* Scores the leaves of the search with leaf_evaluator instead of the
+		weighted evaluation functions, an empty one switches back. */
+	void set_leaf_evaluator(const LeafEvaluator& leaf_evaluator);
+
+	/* Scores a position on its own with the weighted evaluation functions,
+		lower is better. Safe to call from several threads at once. */
+	double evaluate(const PlayField& play_field) const;
+
+	/* Scores the board left after locking locked_pieces on from, the way the
+		search scores its leaves. Also safe to call from several threads. */
+	double evaluate(const PlayField& from, const PlayField& to, const std::vector<Piece>& locked_pieces) const;
+private:
+	/* What the search of one depth works with, kept between searches. */
+	struct Layer
+	{
+		explicit Layer(const Reachability& reachability)
+			: generator(reachability), generated(false)
+		{}
+
+		PlacementGenerator generator;
+		/* where the piece can lock on the board searched last at this depth */
+		std::vector<Piece> placements;
+		/* false if placements came from expansions_, the generator then has
+			to run again before it can make a recording */
+		bool generated;
+	};
+
+	/*	What the last search planned for the piece after the one it placed.
+		If the next search starts from the board that placement left behind,
+		the plan is a move to fall back on before anything is searched. */
+	struct Subtree
+	{
+		Subtree()
+			: valid(false), root(0, 0), depth(0)
+		{}
+
+		bool matches(const PlayField& play_field, const Piece& spawn_piece) const;
+
+		bool valid;
+		PlayField root;
+		Piece spawn_piece;
+		Piece placement;
+		Recording recording;
+		int depth;
+	};
+
+	/* Returns the index in the layer's placements of where the piece at
+		this depth locks best and its value in best_value, or -1 if it could
+		not lock or the search was aborted. */
+	int search(PlayField& original_play_field, PlayField& play_field, int depth, const std::vector<Piece>& piece_queue, const std::vector<Piece>& locked_pieces, double& best_value);
+
+	/* Readies a layer per piece of piece_queue. Nothing is reallocated while
+		the queue length stays the same. */
+	void prepare_layers(const std::vector<Piece>& piece_queue);
+	/* Fills the layer's placements for spawn_piece on play_field, from
+		expansions_ if the board was expanded before. */
+	void expand(int depth, const PlayField& play_field, const Piece& spawn_piece);
+	/* The inputs to placement, one of the placements of spawn_piece on play_field at depth. */
+	Recording make_recording(int depth, const PlayField& play_field, const Piece& spawn_piece, const Piece& placement);
+	/* The weighted evaluation of a leaf, from leaves_ if it was scored before. */
+	double leaf_value(const PlayField& from, const PlayField& to, const std::vector<Piece>& locked_pieces);
+	/* Drops the expansions and leaves that are not under the given
+		placement of the first piece in the search that just ended. */
+	void keep_branch(int branch);
+
+	double evaluate_play_field(const PlayField& from, const PlayField& to, const std::vector<Piece>& piece_queue) const;
+
+	typedef std::function<double(const PlayField& from, const PlayField& to, const std::vector<Piece>& piece_queue)> evaluation_function;
+	std::vector<std::pair<evaluation_function, double>> evaluations_;
+	LeafEvaluator leaf_evaluator_;
+
+	/*	A board the search below some depth already looked at, and the best
+		value found under it. The same board is often left by placing the
+		queue's pieces in another order, it is only searched once per depth.
+		Boards at the last depth are scored on their own and never kept, the
+		weighted evaluation there looks at the piece that locked last. */
+	struct Transposition
+	{
+		Transposition(const PlayField& play_field_, double value_)
+			: play_field(play_field_), value(value_)
+		{}
+
+		PlayField play_field;
+		double value;
+	};
+	/* one map per depth, keyed by PlayField::hash, cleared for every search */
+	std::vector<std::unordered_map<uint64_t, Transposition>> transpositions_;
+
+	/*	The next search starts from the board the chosen placement left, so
+		the boards below that placement come up again, as they do in every
+		deepening step. Their placement lists are kept, and with a time
+		budget or stop flag their leaf values too, so that only boards with
+		a newly revealed piece cost new work. Entries are keyed by board hash
+		and remember under which placement of the first piece they were last
+		met. After each search only those under the chosen one are kept. */
+	struct Expansion
+	{
+		Expansion(const PlayField& play_field_, const Piece& spawn_piece_, const std::vector<Piece>& placements_)
+			: play_field(play_field_), spawn_piece(spawn_piece_), placements(placements_), search(0), branch(-1)
+		{}
+
+		PlayField play_field;
+		Piece spawn_piece;
+		std::vector<Piece> placements;
+		long long search;
+		int branch;
+	};
+	/*	The weighted evaluation only looks at the board, the lines cleared
+		since the root and the piece locked last, so a leaf value holds for
+		any root. Leaf evaluators are not cached, they may look at more. */
+	struct Leaf
+	{
+		Leaf(const PlayField& play_field_, const Piece& last_, int lines_, double value_)
+			: play_field(play_field_), last(last_), lines(lines_), value(value_), search(0), branch(-1)
+		{}
+
+		PlayField play_field;
+		Piece last;
+		int lines;
+		double value;
+		long long search;
+		int branch;
+	};
+	static const size_t max_cached = 1 << 16;
+	std::unordered_map<uint64_t, Expansion> expansions_;
+	std::unordered_map<uint64_t, Leaf> leaves_;
+	/* find_move calls so far, and the placement of the first piece being searched, -1 at the root */
+	long long searches_;
+	int branch_;
+	/* leaves only come up again when deepening */
+	bool cache_leaves_;
+	long long reused_;
+
+	/* polls the deadline and stop flag every now and then, returns true once
+		either says to give up */
+	bool out_of_time();
+
+	Reachability reachability_;
+
+	std::vector<Layer> layers_;
+	Subtree subtree_;
+	/* the best second piece found under the best first piece so far */
+	Piece principal_child_;
+	Recording principal_recording_;
+	bool has_principal_child_;
+
+	long long nodes_;
+	long long duplicates_;
+	/* calls to out_of_time, which only looks at the clock every few */
+	long long polls_;
+	bool has_deadline_;
+	/* set once there is a move to fall back on, before that nothing aborts */
+	bool has_fallback_;
+	bool aborted_;
+	std::chrono::steady_clock::time_point deadline_;
+	const std::atomic<bool>* stop_;
+};
\ No newline at end of file
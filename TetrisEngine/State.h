@@ -0,0 +1,28 @@
+#pragma once
+
+/*
+ *	http://meatfighter.com/nintendotetrisai/#The_Algorithm
+ */
+
+#include "Piece.h"
+#include <cstddef>
+#include <cstdint>
+
+/*	What the search keeps for a position of the piece it places, only
+	meaningful once the position was visited. A layer
+	has one for every rotation, x and y of the field, all of the same type,
+	so the position is the Piece::Id without its type bits. */
+struct State
+{
+	/* no position, a real id never has all its type bits set */
+	static const Piece::Id none = 0xffff;
+
+	/* rotation in bits 0-1, x in bits 2-6 and y in bits 7-12 */
+	static int index(Piece::Id id) { return id >> 3; }
+	static size_t layer_size(int rows) { return static_cast<size_t>(rows) << 7; }
+
+	/* the position this one was first reached from, itself for the spawn */
+	Piece::Id predecessor;
+	/* moves and rotations made since the piece entered its current row */
+	uint8_t row_inputs;
+};
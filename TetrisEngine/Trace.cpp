@@ -0,0 +1,181 @@
+#include "Trace.h"
+
+#ifdef TETRIS_TRACE
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#endif
+
+#ifdef TETRIS_ITT
+#include <ittnotify.h>
+#endif
+
+namespace
+{
+	struct Event
+	{
+		const char* name;
+		uint64_t nanoseconds;
+		char phase;
+	};
+
+	struct ThreadBuffer
+	{
+		ThreadBuffer(int tid_)
+			: events(Trace::buffer_size)
+			, count(0)
+			, tid(tid_)
+		{}
+
+		std::vector<Event> events;
+		uint64_t count;
+		int tid;
+		std::string name;
+	};
+
+	/* Buffers outlive their threads so that they can still be written. */
+	std::mutex buffers_mutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	thread_local ThreadBuffer* local_buffer = nullptr;
+
+	const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+#ifdef __linux__
+	int marker_fd = -1;
+#endif
+
+#ifdef TETRIS_ITT
+	__itt_domain* itt_domain = __itt_domain_create("TetrisSolver");
+#endif
+
+	ThreadBuffer& get_buffer()
+	{
+		if (local_buffer == nullptr)
+		{
+			std::lock_guard<std::mutex> lock(buffers_mutex);
+			buffers.emplace_back(new ThreadBuffer(static_cast<int>(buffers.size()) + 1));
+			local_buffer = buffers.back().get();
+		}
+		return *local_buffer;
+	}
+
+	void record(const char* name, char phase)
+	{
+		auto elapsed = std::chrono::steady_clock::now() - epoch;
+		ThreadBuffer& buffer = get_buffer();
+		Event& event = buffer.events[buffer.count % Trace::buffer_size];
+		event.name = name;
+		event.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+		event.phase = phase;
+		++buffer.count;
+	}
+
+	void write_marker(const char* name, char phase)
+	{
+#ifdef __linux__
+		if (marker_fd != -1)
+		{
+			/* the systrace format, understood by perf script and Perfetto */
+			char line[256];
+			int length = phase == 'B'
+				? std::snprintf(line, sizeof(line), "B|%d|%s\n", static_cast<int>(getpid()), name)
+				: std::snprintf(line, sizeof(line), "E|%d\n", static_cast<int>(getpid()));
+			if (length > 0 && write(marker_fd, line, length) < 0)
+			{
+				marker_fd = -1;
+			}
+		}
+#endif
+	}
+}
+
+void Trace::begin(const char* name)
+{
+	record(name, 'B');
+	write_marker(name, 'B');
+#ifdef TETRIS_ITT
+	__itt_task_begin(itt_domain, __itt_null, __itt_null, __itt_string_handle_create(name));
+#endif
+}
+
+void Trace::end(const char* name)
+{
+#ifdef TETRIS_ITT
+	__itt_task_end(itt_domain);
+#endif
+	write_marker(name, 'E');
+	record(name, 'E');
+}
+
+void Trace::set_thread_name(const std::string& name)
+{
+	get_buffer().name = name;
+#ifdef TETRIS_ITT
+	__itt_thread_set_name(name.c_str());
+#endif
+}
+
+bool Trace::enable_markers()
+{
+#ifdef __linux__
+	if (marker_fd == -1)
+	{
+		marker_fd = open("/sys/kernel/tracing/trace_marker", O_WRONLY | O_CLOEXEC);
+	}
+	if (marker_fd == -1)
+	{
+		marker_fd = open("/sys/kernel/debug/tracing/trace_marker", O_WRONLY | O_CLOEXEC);
+	}
+	return marker_fd != -1;
+#else
+	return false;
+#endif
+}
+
+bool Trace::write_chrome_json(const std::string& path)
+{
+	std::ofstream out(path);
+	if (!out)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(buffers_mutex);
+	out << std::fixed << std::setprecision(3);
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+	bool first = true;
+	for (auto& buffer : buffers)
+	{
+		if (!buffer->name.empty())
+		{
+			out << (first ? "" : ",\n");
+			out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->tid
+				<< ", \"args\": {\"name\": \"" << buffer->name << "\"}}";
+			first = false;
+		}
+
+		uint64_t start = buffer->count > static_cast<uint64_t>(buffer_size) ? buffer->count - buffer_size : 0;
+		for (uint64_t i = start; i < buffer->count; ++i)
+		{
+			const Event& event = buffer->events[i % buffer_size];
+			out << (first ? "" : ",\n");
+			out << "{\"name\": \"" << event.name << "\", \"ph\": \"" << event.phase
+				<< "\", \"ts\": " << event.nanoseconds / 1000.0
+				<< ", \"pid\": 1, \"tid\": " << buffer->tid << "}";
+			first = false;
+		}
+	}
+	out << "\n]}\n";
+	return static_cast<bool>(out);
+}
+
+#endif
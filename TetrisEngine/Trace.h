@@ -0,0 +1,75 @@
+#pragma once
+
+/*	Event tracing for the game loop and the solver.
+ *	Define TETRIS_TRACE to record begin/end events into a ring buffer per
+ *	thread. Trace::write_chrome_json writes everything that is still in the
+ *	buffers in the Chrome trace-event format (load it in chrome://tracing or
+ *	Perfetto).
+ *
+ *	Trace::enable_markers additionally writes every event to the kernel
+ *	trace_marker file, so that `perf record -e ftrace:print` (or any other
+ *	ftrace based profiler) shows the solver phases next to its samples.
+ *	Define TETRIS_ITT as well to forward the events to Intel ITT (VTune).
+ *
+ *	Without TETRIS_TRACE the TRACE_* macros expand to nothing.
+ */
+
+#ifdef TETRIS_TRACE
+
+#include <cstdint>
+#include <string>
+
+class Trace
+{
+public:
+	/* Events kept per thread, older events are overwritten. */
+	static const int buffer_size = 1 << 16;
+
+	static void begin(const char* name);
+	static void end(const char* name);
+
+	/* Names the calling thread in the written trace. */
+	static void set_thread_name(const std::string& name);
+
+	/* Returns false if no trace_marker file could be opened. */
+	static bool enable_markers();
+
+	/* Should be called when the traced threads are idle, the buffers
+		are read without synchronization. */
+	static bool write_chrome_json(const std::string& path);
+
+	class Scope
+	{
+	public:
+		Scope(const char* name)
+			: name_(name)
+		{
+			begin(name_);
+		}
+
+		~Scope()
+		{
+			end(name_);
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	private:
+		const char* name_;
+	};
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_BEGIN(name) Trace::begin(name)
+#define TRACE_END(name) Trace::end(name)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_END(name) ((void)0)
+
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Piece.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/*	The positions a search has reached, one bit for every rotation, x and y
+	of the field: 800 bits for 10 by 20, so clearing it between searches
+	is a handful of stores rather than a pass over every state. */
+class VisitedSet
+{
+public:
+	VisitedSet()
+		: width_(0)
+	{}
+
+	/* Sizes the set for a field and empties it. */
+	void reset(int width, int rows)
+	{
+		width_ = width;
+		bits_.assign((static_cast<size_t>(width) * rows * 4 + 63) / 64, 0);
+	}
+
+	void clear()
+	{
+		std::fill(bits_.begin(), bits_.end(), 0);
+	}
+
+	bool contains(Piece::Id id) const
+	{
+		size_t bit = bit_of(id);
+		return ((bits_[bit / 64] >> (bit % 64)) & 1) != 0;
+	}
+
+	/* Returns false if the position was in the set already. */
+	bool insert(Piece::Id id)
+	{
+		size_t bit = bit_of(id);
+		uint64_t mask = uint64_t(1) << (bit % 64);
+		if ((bits_[bit / 64] & mask) != 0)
+		{
+			return false;
+		}
+		bits_[bit / 64] |= mask;
+		return true;
+	}
+
+private:
+	/* (y * width + x) * 4 + rotation, read straight from the id's fields */
+	size_t bit_of(Piece::Id id) const
+	{
+		return ((static_cast<size_t>(id >> 10) * width_ + ((id >> 5) & 31)) << 2) | ((id >> 3) & 3);
+	}
+
+	std::vector<uint64_t> bits_;
+	int width_;
+};
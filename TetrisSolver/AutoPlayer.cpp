@@ -0,0 +1,60 @@
+#include "AutoPlayer.h"
+#include "Profiler.h"
+#include "Trace.h"
+
+AutoPlayer::AutoPlayer()
+	: current_piece_count_(-1)
+{}
+
+void AutoPlayer::update(Board& board)
+{
+	if (board.get_piece_count() != current_piece_count_)
+	{
+		auto& current_piece = board.get_current_piece();
+		if (!board.test_collision(current_piece))
+		{
+			current_piece_count_ = board.get_piece_count();
+			start_search(board);
+		}
+	}
+
+	play_recorded_actions(board);
+}
+
+void AutoPlayer::play_recorded_actions(Board& board)
+{
+	if (action_recording_.size() == 0)
+	{
+		board.tick();
+		return;
+	}
+	else
+	{
+		auto& top_frame = action_recording_.front();
+		if (top_frame.size() == 0)
+		{
+			board.tick();
+			action_recording_.pop_front();
+		}
+		else
+		{
+			board.perform_action(top_frame.front());
+			top_frame.pop_front();
+		}
+	}
+}
+
+void AutoPlayer::start_search(Board& board)
+{
+	TRACE_SCOPE("AutoPlayer::start_search");
+	PlayField play_field = board.create_play_field();
+	
+	std::vector<Piece> piece_queue;
+	piece_queue.push_back(board.get_current_piece());
+	for (int i = 0; i < 1; ++i)
+	{
+		piece_queue.push_back(board.get_next_piece(i));
+	}
+	action_recording_ = std::move(solver_.find_move(play_field, piece_queue, 0).recording);
+	PROFILE_END_PIECE();
+}
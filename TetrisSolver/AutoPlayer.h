@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Board.h"
+#include "Solver.h"
+
+/*	Lets the Solver play a Board. Every new piece is searched for once, the
+	recorded inputs are then fed to the board one per update. */
+class AutoPlayer
+{
+public:
+	AutoPlayer();
+	void update(Board& board);
+private:
+	void start_search(Board& board);
+	void play_recorded_actions(Board& board);
+
+	Solver solver_;
+	Solver::Recording action_recording_;
+	int current_piece_count_;
+};
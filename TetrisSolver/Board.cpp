@@ -1,13 +1,28 @@
 #include "Board.h"
+#include <algorithm>
 #include <exception>
 
 Board::Board(int x, int y, int tile_size)
+	: field_(BOARD_WIDTH, BOARD_HEIGHT, BOARD_BUFFER_ROWS)
+{
+	std::random_device rd;
+	init(x, y, tile_size, rd());
+}
+
+Board::Board(int x, int y, int tile_size, unsigned int seed)
+	: field_(BOARD_WIDTH, BOARD_HEIGHT, BOARD_BUFFER_ROWS)
+{
+	init(x, y, tile_size, seed);
+}
+
+void Board::init(int x, int y, int tile_size, unsigned int seed)
 {
 	piece_count_ = 0;
+	game_over_ = false;
+	colors_.fill(Color::black());
 
-	std::random_device rd;
-	random_engine_ = std::mt19937(rd());
-	clear_colors();
+	seed_ = seed;
+	random_engine_ = std::mt19937(seed);
 	x_ = x + tile_size;
 	y_ = y + tile_size;
 	tile_size_ = tile_size;
@@ -24,113 +39,46 @@ Board::Board(int x, int y, int tile_size)
 	next_piece_queue_.push_back(random_piece());
 }
 
-void Board::render(Window& window)
-{
-	clear_colors();
-	render_tiles();
-	render_live_piece();
-	render_board(window);
-}
-
-void Board::render_tiles()
+void Board::make_snapshot(Snapshot& snapshot) const
 {
-	for (int x = 0; x < BOARD_WIDTH; ++x)
-	{
-		for (int y = 0; y < BOARD_HEIGHT; ++y)
-		{
-			if (tiles_[y * BOARD_WIDTH + x].occupied)
-			{
-				colors_[y * BOARD_WIDTH + x] = tiles_[y * BOARD_WIDTH + x].color;
-			}
-		}
-	}
-}
-
-void Board::render_live_piece()
-{
-	Color color = current_piece_.get_color();
-	auto tiles = current_piece_.get_tiles();
-	for (int i = 0; i < PIECE_SIZE; ++i)
+	for (int y = 0; y < BOARD_HEIGHT; ++y)
 	{
-		for (int j = 0; j < PIECE_SIZE; ++j)
+		PlayField::Row row = field_.get_row(y);
+		for (int x = 0; x < BOARD_WIDTH; ++x)
 		{
-			int x = current_piece_.get_x() + i - 2;
-			int y = current_piece_.get_y() + j - 2;
-			if (x >= 0 && x < BOARD_WIDTH && y >= 0 && y < BOARD_HEIGHT && tiles[j * PIECE_SIZE + i] != 0)
+			uint32_t rgba = 0;
+			if ((row >> x) & 1)
 			{
-				set_color(color, x, y);
+				const Color& color = color_at(x, y);
+				rgba = (static_cast<uint32_t>(color.get_red_byte()) << 24)
+					| (static_cast<uint32_t>(color.get_green_byte()) << 16)
+					| (static_cast<uint32_t>(color.get_blue_byte()) << 8)
+					| static_cast<uint32_t>(color.get_alpha_byte());
 			}
+			snapshot.colors[y * BOARD_WIDTH + x] = rgba;
 		}
+		snapshot.rows[y] = static_cast<uint16_t>(row);
 	}
+	snapshot.live_piece = current_piece_;
+	snapshot.piece_count = piece_count_;
 }
 
-void Board::render_board(Window& window)
-{
-	for (int x = 0; x < BOARD_WIDTH; ++x)
-	{
-		window.RenderRectangle(x_ + (x * tile_size_), y_ + (-1 * tile_size_), tile_size_, tile_size_, Color::white());
-		window.RenderRectangle(x_ + (x * tile_size_), y_ + ((BOARD_HEIGHT) * tile_size_), tile_size_, tile_size_, Color::white());
-	}
-
-	for (int y = -1; y <= BOARD_HEIGHT; ++y)
-	{
-		window.RenderRectangle(x_ + (-1 * tile_size_), y_ + (y * tile_size_), tile_size_, tile_size_, Color::white());
-		window.RenderRectangle(x_ + ((BOARD_WIDTH) * tile_size_), y_ + (y * tile_size_), tile_size_, tile_size_, Color::white());
-	}
-
-	for (int x = 0; x < BOARD_WIDTH; ++x)
-	{
-		for (int y = 0; y < BOARD_HEIGHT; ++y)
-		{
-			window.RenderRectangle(x_ + (x * tile_size_), y_ + (y * tile_size_), tile_size_, tile_size_, colors_[y * BOARD_WIDTH + x]);
-		}
-	}
-}
-
-void Board::clear_colors()
+bool Board::test_collision(const Piece& piece) const
 {
-	for (auto& tile : colors_)
-	{
-		tile = Color::black();
-	}
+	return field_.test_collision(piece);
 }
 
-void Board::set_color(Color color, int x, int y)
+int Board::drop_distance(const Piece& piece) const
 {
-	if (x >= BOARD_WIDTH || y >= BOARD_HEIGHT || x < 0 || y < 0)
-	{
-		throw std::out_of_range("Tile must be inside the board");
-	}
-	colors_[y * BOARD_WIDTH + x] = color;
+	return field_.landing_y(piece) - piece.get_y();
 }
 
-bool Board::test_collision(const Piece& piece) const
+void Board::hard_drop()
 {
-	auto tiles = piece.get_tiles();
-	for (int i = 0; i < PIECE_SIZE; ++i)
+	if (!test_collision(current_piece_))
 	{
-		for (int j = 0; j < PIECE_SIZE; ++j)
-		{
-			int x = piece.get_x() + i - 2;
-			int y = piece.get_y() + j - 2;
-			if (tiles[j * PIECE_SIZE + i] != 0)
-			{
-				if (y >= BOARD_HEIGHT)
-				{
-					return true;
-				}
-				else if (x >= 0 && x < BOARD_WIDTH && y >= 0 && y < BOARD_HEIGHT && tiles_[y * BOARD_WIDTH + x].occupied)
-				{
-					return true;
-				}
-				else if (!(x >= 0 && x < BOARD_WIDTH))
-				{
-					return true;
-				}
-			}
-		}
+		current_piece_.move(0, drop_distance(current_piece_));
 	}
-	return false;
 }
 
 /*
@@ -174,61 +122,49 @@ bool Board::perform_action(Action action)
 */
 int Board::tick()
 {
-	current_piece_.move(0, 1);
-	bool collided = test_collision(current_piece_);
-
-	if (collided)
+	/* pieces only ever move to free tiles, so this means it spawned inside the stack */
+	if (test_collision(current_piece_))
 	{
-		while (collided)
-		{
-			current_piece_.move(0, -1);
-			collided = test_collision(current_piece_) && current_piece_.get_y() > -5;
-		}
+		game_over_ = true;
+		return -1;
+	}
+	if (drop_distance(current_piece_) > 0)
+	{
+		current_piece_.move(0, 1);
+		return 0;
+	}
 
-		if (imprint_live_piece())
-		{
-			return clear_rows();
-		}
-		else
-		{
-			return -1;
-		}
+	if (imprint_live_piece())
+	{
+		return clear_rows();
 	}
-	return 0;
+	game_over_ = true;
+	return -1;
 }
 
 /* Returns number of rows cleared. */
 int Board::clear_rows()
 {
-	int cleared = 0;
-	for (int row = 0; row < BOARD_HEIGHT; ++row)
+	/* the field already cleared them, the colors follow in one pass up from
+		the bottom using its mask of cleared rows */
+	uint64_t cleared_mask = field_.get_last_cleared_mask();
+	if (cleared_mask != 0)
 	{
-		bool occ = true;
-		for (int col = 0; col < BOARD_WIDTH; ++col)
-		{
-			if (!tiles_[row * BOARD_WIDTH + col].occupied)
-			{
-				occ = false;
-				break;
-			}
-		}
-		if (occ)
+		int write = BOARD_HEIGHT - 1;
+		for (int read = BOARD_HEIGHT - 1; read >= -BOARD_BUFFER_ROWS; --read)
 		{
-			++cleared;
-			for (int col = 0; col < BOARD_WIDTH; ++col)
+			if ((cleared_mask >> (read + BOARD_BUFFER_ROWS)) & 1)
 			{
-				tiles_[row * BOARD_WIDTH + col].occupied = false;
+				continue;
 			}
-			for (int y = row; y >= 1; --y)
+			if (write != read)
 			{
-				for (int x = 0; x < BOARD_WIDTH; ++x)
-				{
-					tiles_[y* BOARD_WIDTH + x] = tiles_[(y - 1) * BOARD_WIDTH + x];
-				}
+				std::copy(&color_at(0, read), &color_at(0, read) + BOARD_WIDTH, &color_at(0, write));
 			}
+			--write;
 		}
 	}
-	return cleared;
+	return field_.get_last_cleared();
 }
 
 /* returns true if the piece was imprintable. Ie: if this function returns false,
@@ -243,18 +179,23 @@ bool Board::imprint_live_piece()
 		{
 			int x = current_piece_.get_x() + i - 2;
 			int y = current_piece_.get_y() + j - 2;
-			if (x >= 0 && x < BOARD_WIDTH && y >= -1 && y < BOARD_HEIGHT && tiles[j * PIECE_SIZE + i] != 0)
+			if (x >= 0 && x < BOARD_WIDTH && y >= -BOARD_BUFFER_ROWS && y < BOARD_HEIGHT && tiles[j * PIECE_SIZE + i] != 0)
 			{
-				if (y == -1)
-				{
-					return false;
-				}
-				tiles_[y * BOARD_WIDTH + x].occupied = true;
-				tiles_[y * BOARD_WIDTH + x].color = color;
+				color_at(x, y) = color;
 			}
 		}
 	}
+	/* this also clears the rows, clear_rows only has to catch the colors up */
+	if (!field_.imprint(current_piece_))
+	{
+		return false;
+	}
 	
+	if (lock_listener_)
+	{
+		lock_listener_(current_piece_);
+	}
+
 	current_piece_ = next_piece_queue_.front();
 	next_piece_queue_.pop_front();
 
@@ -285,7 +226,7 @@ Piece Board::random_piece()
 		//that too
 		rotation = 0;
 
-		Piece ret = piece_makers[piece](x, 0, rotation);
+		Piece ret = piece_makers[piece](x, spawn_y(), rotation);
 		
 		auto tiles = ret.get_tiles();
 		for (int i = 0; i < PIECE_SIZE; ++i)
@@ -312,17 +253,14 @@ int Board::get_piece_count() const
 	return piece_count_;
 }
 
+void Board::set_lock_listener(std::function<void(const Piece&)> listener)
+{
+	lock_listener_ = listener;
+}
+
 PlayField Board::create_play_field() const
 {
-	PlayField ret(BOARD_WIDTH, BOARD_HEIGHT);
-	for (int y = 0; y < BOARD_HEIGHT; ++y)
-	{
-		for (int x = 0; x < BOARD_WIDTH; ++x)
-		{
-			ret.set(x, y, tiles_[y * BOARD_WIDTH + x].occupied);
-		}
-	}
-	return std::move(ret);
+	return field_;
 }
 
 const Piece& Board::get_current_piece() const
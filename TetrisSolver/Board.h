@@ -1,68 +1,113 @@
 #pragma once
 
-#include "Window.h"
+#include "Action.h"
+#include "Color.h"
 #include <array>
 #include "Piece.h"
 #include <random>
 #include <functional>
 #include "PlayField.h"
 #include <deque>
+#include <cstdint>
 
 #define BOARD_HEIGHT 20
 #define BOARD_WIDTH 10
+/* hidden rows above the visible ones, pieces spawn in them */
+#define BOARD_BUFFER_ROWS 20
+
+class Window;
 
 class Board
 {
 public:
-	enum Action { Rotate, Left, Right };
+	/*	A compact copy of everything needed to draw the board. It does not
+		refer back to the Board, so it can be handed to another thread. */
+	struct Snapshot
+	{
+		bool occupied(int x, int y) const
+		{
+			return (rows[y] >> x) & 1;
+		}
+
+		Color get_color(int x, int y) const
+		{
+			uint32_t rgba = colors[y * BOARD_WIDTH + x];
+			return Color::make_from_bytes(rgba >> 24, (rgba >> 16) & 0xff, (rgba >> 8) & 0xff, rgba & 0xff);
+		}
+
+		/* bit x of a row is set if that tile is occupied */
+		std::array<uint16_t, BOARD_HEIGHT> rows;
+		/* RGBA, only meaningful for occupied tiles */
+		std::array<uint32_t, BOARD_HEIGHT * BOARD_WIDTH> colors;
+		Piece live_piece;
+		int piece_count;
+	};
 
 	Board(int x, int y, int tile_size);
+	/* The seed decides the whole piece sequence. */
+	Board(int x, int y, int tile_size, unsigned int seed);
 	void render(Window& window);
 
+	/*	Draws a snapshot of this board. Only the board's position and tile
+		size are read from the Board itself, and those never change, so this
+		is safe to call while another thread keeps playing. */
+	void render(const Snapshot& snapshot, Window& window) const;
+	void make_snapshot(Snapshot& snapshot) const;
+
 	bool perform_action(Action action);
 
 	int tick();
+	/* How many rows the piece can still fall before it rests on the stack
+		or the floor, the piece must not be colliding. */
+	int drop_distance(const Piece& piece) const;
+	/* Drops the live piece straight down to where it lands, it locks on
+		the next tick. */
+	void hard_drop();
 
 	bool test_collision(const Piece& piece) const;
 	
 	const Piece& get_current_piece() const;
 	const Piece& get_next_piece(int index);
 	int get_piece_count() const;
+	unsigned int get_seed() const { return seed_; }
+	/* True once a piece could not be placed. */
+	bool is_game_over() const { return game_over_; }
+
+	/* Called with every piece that locks into the board. */
+	void set_lock_listener(std::function<void(const Piece&)> listener);
 
 	PlayField create_play_field() const;
 
 	int get_width() const { return BOARD_WIDTH; }
 	int get_height() const { return BOARD_HEIGHT; }
+	int get_buffer_rows() const { return BOARD_BUFFER_ROWS; }
+	/* Rows cleared by the last piece that locked, bit y + BOARD_BUFFER_ROWS for row y. */
+	uint64_t get_last_cleared_mask() const { return field_.get_last_cleared_mask(); }
 private:
-	struct  Tile
-	{
-		Tile()
-			:color(Color::black()), occupied(false)
-		{}
-
-		Tile(Color color_, bool occupied_)
-			:color(color_), occupied(occupied_)
-		{}
-		Color color;
-		bool occupied;
-	};
-
-	void render_board(Window& window);
-	void render_tiles();
-	void render_live_piece();
-	void set_color(Color color, int x, int y);
-	void clear_colors();
 	bool imprint_live_piece();
+	/* see PlayField::get_spawn_y */
+	int spawn_y() const { return BOARD_BUFFER_ROWS < 2 ? -BOARD_BUFFER_ROWS : -2; }
+	/* Moves the colors down past the rows the last lock cleared. */
 	int clear_rows();
 
+	void init(int x, int y, int tile_size, unsigned int seed);
 	Piece random_piece();
 	int next_random(int min, int max);
 
 	int x_, y_, tile_size_;
-	std::array<Color, BOARD_HEIGHT * BOARD_WIDTH> colors_;
-	std::array<Tile, BOARD_HEIGHT * BOARD_WIDTH> tiles_;
+	/* Color of a row y is at (y + BOARD_BUFFER_ROWS) * BOARD_WIDTH + x. */
+	Color& color_at(int x, int y) { return colors_[(y + BOARD_BUFFER_ROWS) * BOARD_WIDTH + x]; }
+	const Color& color_at(int x, int y) const { return colors_[(y + BOARD_BUFFER_ROWS) * BOARD_WIDTH + x]; }
+
+	/* Which tiles are occupied, everything but drawing only looks at this. */
+	PlayField field_;
+	/* Only meaningful for occupied tiles, read when drawing. */
+	std::array<Color, (BOARD_BUFFER_ROWS + BOARD_HEIGHT) * BOARD_WIDTH> colors_;
 
+	unsigned int seed_;
 	std::mt19937 random_engine_;
+	std::function<void(const Piece&)> lock_listener_;
+	bool game_over_;
 	std::vector<std::function<Piece(int, int, int)>> piece_makers;
 	
 	Piece current_piece_;
@@ -0,0 +1,52 @@
+#include "Board.h"
+#include "Window.h"
+
+/*	Drawing is kept apart from the rules so that the headless builds can
+	leave SDL out entirely. */
+
+void Board::render(Window& window)
+{
+	Snapshot snapshot;
+	make_snapshot(snapshot);
+	render(snapshot, window);
+}
+
+void Board::render(const Snapshot& snapshot, Window& window) const
+{
+	for (int x = 0; x < BOARD_WIDTH; ++x)
+	{
+		window.RenderRectangle(x_ + (x * tile_size_), y_ + (-1 * tile_size_), tile_size_, tile_size_, Color::white());
+		window.RenderRectangle(x_ + (x * tile_size_), y_ + ((BOARD_HEIGHT) * tile_size_), tile_size_, tile_size_, Color::white());
+	}
+
+	for (int y = -1; y <= BOARD_HEIGHT; ++y)
+	{
+		window.RenderRectangle(x_ + (-1 * tile_size_), y_ + (y * tile_size_), tile_size_, tile_size_, Color::white());
+		window.RenderRectangle(x_ + ((BOARD_WIDTH) * tile_size_), y_ + (y * tile_size_), tile_size_, tile_size_, Color::white());
+	}
+
+	for (int x = 0; x < BOARD_WIDTH; ++x)
+	{
+		for (int y = 0; y < BOARD_HEIGHT; ++y)
+		{
+			Color color = snapshot.occupied(x, y) ? snapshot.get_color(x, y) : Color::black();
+			window.RenderRectangle(x_ + (x * tile_size_), y_ + (y * tile_size_), tile_size_, tile_size_, color);
+		}
+	}
+
+	const Piece& piece = snapshot.live_piece;
+	Color color = piece.get_color();
+	auto tiles = piece.get_tiles();
+	for (int i = 0; i < PIECE_SIZE; ++i)
+	{
+		for (int j = 0; j < PIECE_SIZE; ++j)
+		{
+			int x = piece.get_x() + i - 2;
+			int y = piece.get_y() + j - 2;
+			if (x >= 0 && x < BOARD_WIDTH && y >= 0 && y < BOARD_HEIGHT && tiles[j * PIECE_SIZE + i] != 0)
+			{
+				window.RenderRectangle(x_ + (x * tile_size_), y_ + (y * tile_size_), tile_size_, tile_size_, color);
+			}
+		}
+	}
+}
@@ -0,0 +1,147 @@
+#include "Dataset.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	const char magic[4] = { 'T', 'S', 'D', 'S' };
+}
+
+size_t DatasetFormat::record_size(int rows)
+{
+	size_t size = rows * sizeof(uint16_t) + 4 + sizeof(float);
+	return (size + 3) & ~static_cast<size_t>(3);
+}
+
+DatasetWriter::DatasetWriter(const std::string& path, int width, int height, int buffer_rows)
+	: file_(width <= DatasetFormat::max_width ? std::fopen(path.c_str(), "wb") : nullptr)
+	, width_(width)
+	, height_(height)
+	, buffer_rows_(buffer_rows)
+	, record_(DatasetFormat::record_size(buffer_rows + height), 0)
+{
+	if (file_ == nullptr)
+	{
+		return;
+	}
+
+	unsigned char header[DatasetFormat::header_size] = {};
+	std::memcpy(header, magic, sizeof(magic));
+	header[4] = DatasetFormat::version;
+	header[5] = static_cast<unsigned char>(width);
+	header[6] = static_cast<unsigned char>(height);
+	header[7] = static_cast<unsigned char>(buffer_rows);
+	uint32_t record_size = static_cast<uint32_t>(record_.size());
+	std::memcpy(header + 8, &record_size, sizeof(record_size));
+	std::fwrite(header, 1, sizeof(header), file_);
+}
+
+DatasetWriter::~DatasetWriter()
+{
+	if (file_ != nullptr)
+	{
+		std::fclose(file_);
+	}
+}
+
+void DatasetWriter::add(const PlayField& play_field, int current_piece, int next_piece, float label)
+{
+	std::fill(record_.begin(), record_.end(), 0);
+	unsigned char* out = record_.data();
+	for (int y = -buffer_rows_; y < height_; ++y)
+	{
+		uint16_t row = 0;
+		for (int x = 0; x < width_; ++x)
+		{
+			if (play_field.get(x, y))
+			{
+				row |= 1 << x;
+			}
+		}
+		std::memcpy(out, &row, sizeof(row));
+		out += sizeof(uint16_t);
+	}
+	out[0] = static_cast<unsigned char>(current_piece);
+	out[1] = static_cast<unsigned char>(next_piece);
+	std::memcpy(out + 4, &label, sizeof(label));
+	std::fwrite(record_.data(), 1, record_.size(), file_);
+}
+
+PositionDataset::PositionDataset(const std::string& path)
+	: file_(path)
+	, valid_(false)
+	, width_(0)
+	, height_(0)
+	, buffer_rows_(0)
+	, record_size_(0)
+	, count_(0)
+	, records_(nullptr)
+{
+	if (!file_.is_open() || file_.size() < DatasetFormat::header_size)
+	{
+		return;
+	}
+
+	const unsigned char* header = file_.data();
+	if (std::memcmp(header, magic, sizeof(magic)) != 0 || header[4] != DatasetFormat::version)
+	{
+		return;
+	}
+
+	width_ = header[5];
+	if (width_ > DatasetFormat::max_width)
+	{
+		return;
+	}
+	height_ = header[6];
+	buffer_rows_ = header[7];
+	uint32_t record_size;
+	std::memcpy(&record_size, header + 8, sizeof(record_size));
+	record_size_ = record_size;
+	if (record_size_ != DatasetFormat::record_size(buffer_rows_ + height_))
+	{
+		return;
+	}
+
+	records_ = header + DatasetFormat::header_size;
+	count_ = (file_.size() - DatasetFormat::header_size) / record_size_;
+	valid_ = true;
+}
+
+uint16_t PositionDataset::get_row(size_t index, int y) const
+{
+	uint16_t row;
+	std::memcpy(&row, record(index) + (y + buffer_rows_) * sizeof(uint16_t), sizeof(row));
+	return row;
+}
+
+int PositionDataset::get_current_piece(size_t index) const
+{
+	return record(index)[pieces_offset()];
+}
+
+int PositionDataset::get_next_piece(size_t index) const
+{
+	return record(index)[pieces_offset() + 1];
+}
+
+float PositionDataset::get_label(size_t index) const
+{
+	float label;
+	std::memcpy(&label, record(index) + pieces_offset() + 4, sizeof(label));
+	return label;
+}
+
+PlayField PositionDataset::make_play_field(size_t index) const
+{
+	PlayField play_field(width_, height_, buffer_rows_);
+	for (int y = -buffer_rows_; y < height_; ++y)
+	{
+		uint16_t row = get_row(index, y);
+		for (int x = 0; x < width_; ++x)
+		{
+			play_field.set(x, y, ((row >> x) & 1) != 0);
+		}
+	}
+	return play_field;
+}
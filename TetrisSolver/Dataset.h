@@ -0,0 +1,94 @@
+#pragma once
+
+/*	A file of fixed-size position records, meant to be scored over and over
+ *	while tuning the evaluation functions.
+ *
+ *	The file starts with a 16 byte header (magic "TSDS", version, board width
+ *	and height, the number of buffer rows, the 32-bit record size and 4 spare
+ *	bytes). Every record then holds, in native byte order:
+ *
+ *		uint16_t rows[buffer rows + height]	bit x of a row is set if the tile
+ *								is occupied, the top buffer row first
+ *		uint8_t current			type of the piece to place
+ *		uint8_t next			type of the piece after it
+ *		uint16_t				spare
+ *		float label
+ *
+ *	padded to a multiple of 4 bytes, so boards are at most 16 wide. Wider
+ *	ones are neither written nor read. PositionDataset maps the file and reads
+ *	the records where they are, nothing is copied. Files from before there
+ *	were buffer rows have 0 in their place and read as they always did.
+ */
+
+#include "PlayField.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace DatasetFormat
+{
+	const uint8_t version = 1;
+	const size_t header_size = 16;
+	/* the columns a uint16_t row holds */
+	const int max_width = 16;
+
+	/* rows counts the buffer rows too */
+	size_t record_size(int rows);
+}
+
+class DatasetWriter
+{
+public:
+	/* Does not open the file if the board is wider than DatasetFormat::max_width. */
+	DatasetWriter(const std::string& path, int width, int height, int buffer_rows = 0);
+	~DatasetWriter();
+	DatasetWriter(const DatasetWriter&) = delete;
+	DatasetWriter& operator=(const DatasetWriter&) = delete;
+
+	bool is_open() const { return file_ != nullptr; }
+
+	void add(const PlayField& play_field, int current_piece, int next_piece, float label);
+private:
+	FILE* file_;
+	int width_, height_, buffer_rows_;
+	std::vector<unsigned char> record_;
+};
+
+class PositionDataset
+{
+public:
+	explicit PositionDataset(const std::string& path);
+
+	bool is_open() const { return valid_; }
+	size_t size() const { return count_; }
+	int get_width() const { return width_; }
+	int get_height() const { return height_; }
+	int get_buffer_rows() const { return buffer_rows_; }
+
+	/* Row y of the field, from -get_buffer_rows() to get_height() - 1. */
+	uint16_t get_row(size_t index, int y) const;
+	int get_current_piece(size_t index) const;
+	int get_next_piece(size_t index) const;
+	float get_label(size_t index) const;
+
+	PlayField make_play_field(size_t index) const;
+private:
+	const unsigned char* record(size_t index) const
+	{
+		return records_ + index * record_size_;
+	}
+
+	/* where the piece types start */
+	size_t pieces_offset() const
+	{
+		return (buffer_rows_ + height_) * sizeof(uint16_t);
+	}
+
+	MappedFile file_;
+	bool valid_;
+	int width_, height_, buffer_rows_;
+	size_t record_size_;
+	size_t count_;
+	const unsigned char* records_;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <thread>
+
+/*	Paces a loop at a fixed rate, independent of how long each iteration takes.
+ *	If the loop falls behind, at most max_catch_up ticks are run back to back
+ *	and the rest of the lag is dropped, so a long stall does not turn into a
+ *	burst of ticks. In uncapped mode there is no waiting at all.
+ */
+class FixedTimestep
+{
+public:
+	FixedTimestep(double ticks_per_second, int max_catch_up)
+		: step_(std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / ticks_per_second)))
+		, next_(clock::now())
+		, max_catch_up_(max_catch_up)
+		, uncapped_(false)
+	{}
+
+	void set_uncapped(bool uncapped)
+	{
+		uncapped_ = uncapped;
+		next_ = clock::now();
+	}
+
+	bool is_uncapped() const
+	{
+		return uncapped_;
+	}
+
+	/* Returns how many ticks should be run now. */
+	int ticks_due()
+	{
+		if (uncapped_)
+		{
+			return 1;
+		}
+
+		auto now = clock::now();
+		int ticks = 0;
+		while (next_ <= now && ticks < max_catch_up_)
+		{
+			next_ += step_;
+			++ticks;
+		}
+		if (next_ <= now)
+		{
+			next_ = now + step_;
+		}
+		return ticks;
+	}
+
+	/* Sleeps until the next tick is due. */
+	void wait() const
+	{
+		if (!uncapped_)
+		{
+			std::this_thread::sleep_until(next_);
+		}
+	}
+private:
+	typedef std::chrono::steady_clock clock;
+
+	clock::duration step_;
+	clock::time_point next_;
+	int max_catch_up_;
+	bool uncapped_;
+};
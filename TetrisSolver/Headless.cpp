@@ -0,0 +1,171 @@
+#include "Headless.h"
+#include "Replay.h"
+#include "PlayField.h"
+#include "Dataset.h"
+#include "Board.h"
+#include "AutoPlayer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int play_game(unsigned int seed, int max_pieces, const std::function<void(Board&)>& on_piece)
+{
+	Board board(0, 0, 0, seed);
+	AutoPlayer player;
+	int seen = -1;
+	while (!board.is_game_over() && board.get_piece_count() < max_pieces)
+	{
+		if (board.get_piece_count() != seen)
+		{
+			seen = board.get_piece_count();
+			on_piece(board);
+		}
+		player.update(board);
+	}
+	return board.get_piece_count();
+}
+
+int run_replay(const std::string& path)
+{
+	ReplayReader reader(path);
+	if (!reader.is_open())
+	{
+		std::cerr << "Could not open replay: " << path << std::endl;
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	long long games = 0;
+	long long pieces = 0;
+	long long lines = 0;
+	long long invalid = 0;
+
+	ReplayHeader header;
+	while (reader.next_game(header))
+	{
+		PlayField play_field(header.width, header.height, header.buffer_rows);
+		Piece piece;
+		while (reader.next_placement(piece))
+		{
+			if (play_field.test_collision(piece))
+			{
+				++invalid;
+			}
+			play_field.imprint(piece);
+			++pieces;
+		}
+		lines += play_field.get_cleared_rows();
+		++games;
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	std::cout << "games: " << games
+		<< ", pieces: " << pieces
+		<< ", lines: " << lines
+		<< ", invalid placements: " << invalid
+		<< ", " << pieces / std::max(elapsed.count(), 1e-9) << " pieces/s" << std::endl;
+	return invalid == 0 ? 0 : 1;
+}
+
+int run_generate_dataset(const std::string& path, unsigned int seed, int games, int max_pieces)
+{
+	DatasetWriter writer(path, BOARD_WIDTH, BOARD_HEIGHT, BOARD_BUFFER_ROWS);
+	if (!writer.is_open())
+	{
+		std::cerr << "Could not open dataset for writing: " << path << std::endl;
+		return 1;
+	}
+
+	struct Position
+	{
+		Position(const PlayField& play_field_, int current_, int next_)
+			: play_field(play_field_), current(current_), next(next_)
+		{}
+
+		PlayField play_field;
+		int current;
+		int next;
+	};
+
+	long long total = 0;
+	for (int game = 0; game < games; ++game)
+	{
+		std::vector<Position> positions;
+		int pieces = play_game(seed + game, max_pieces, [&positions](Board& board)
+		{
+			positions.emplace_back(board.create_play_field(), board.get_current_piece().get_type(), board.get_next_piece(0).get_type());
+		});
+
+		for (size_t i = 0; i < positions.size(); ++i)
+		{
+			writer.add(positions[i].play_field, positions[i].current, positions[i].next, static_cast<float>(pieces - static_cast<int>(i)));
+		}
+		total += positions.size();
+		std::cout << "game " << game << ": " << pieces << " pieces" << std::endl;
+	}
+	std::cout << "positions: " << total << std::endl;
+	return 0;
+}
+
+int run_evaluate_dataset(const std::string& path, int threads)
+{
+	PositionDataset dataset(path);
+	if (!dataset.is_open())
+	{
+		std::cerr << "Could not open dataset: " << path << std::endl;
+		return 1;
+	}
+	if (threads <= 0)
+	{
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	/* the threads take chunks of records until there are none left */
+	const size_t chunk_size = 4096;
+	std::atomic<size_t> next_chunk(0);
+	std::vector<double> score_sums(threads, 0.0);
+	Solver solver;
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t)
+	{
+		workers.emplace_back([&, t]()
+		{
+			double sum = 0.0;
+			while (true)
+			{
+				size_t begin = next_chunk.fetch_add(chunk_size);
+				if (begin >= dataset.size())
+				{
+					break;
+				}
+				size_t end = std::min(begin + chunk_size, dataset.size());
+				for (size_t i = begin; i < end; ++i)
+				{
+					sum += solver.evaluate(dataset.make_play_field(i));
+				}
+			}
+			score_sums[t] = sum;
+		});
+	}
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	double total = 0.0;
+	for (double sum : score_sums)
+	{
+		total += sum;
+	}
+	std::cout << "positions: " << dataset.size()
+		<< ", threads: " << threads
+		<< ", mean score: " << (dataset.size() > 0 ? total / dataset.size() : 0.0)
+		<< ", " << dataset.size() / std::max(elapsed.count(), 1e-9) << " positions/s" << std::endl;
+	return 0;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+/*	Modes of the solver binary that run without a window. */
+
+#include <functional>
+#include <string>
+
+class Board;
+
+/* Lets the solver play one game on its own, as fast as it can, and calls
+	on_piece every time a new piece is about to be placed. Stops at game
+	over or after max_pieces. Returns the number of pieces placed. */
+int play_game(unsigned int seed, int max_pieces, const std::function<void(Board&)>& on_piece);
+
+/* Replays every game in a replay file as fast as possible and prints what
+	was played. Returns the process exit code. */
+int run_replay(const std::string& path);
+
+/* Plays games and stores every position the solver saw. The label of a
+	position is the number of pieces the game lasted after it. */
+int run_generate_dataset(const std::string& path, unsigned int seed, int games, int max_pieces);
+
+/* Scores every position of a dataset in parallel and prints the throughput. */
+int run_evaluate_dataset(const std::string& path, int threads);
@@ -0,0 +1,267 @@
+#include "Replay.h"
+#include "PlayField.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	const char magic[4] = { 'T', 'S', 'R', 'P' };
+}
+
+bool ReplayFormat::encode(const Piece& piece, int buffer_rows, uint16_t& record)
+{
+	int x = piece.get_x() + 4;
+	int y = piece.get_y() + buffer_rows + 8;
+	if (x < 0 || x > 31 || y < 0 || y > 63)
+	{
+		return false;
+	}
+	record = static_cast<uint16_t>(piece.get_type()
+		| (piece.get_rotation() << 3)
+		| (x << 5)
+		| (y << 10));
+	return true;
+}
+
+bool ReplayFormat::is_game_over(uint16_t record)
+{
+	return (record & 7) == game_over;
+}
+
+Piece ReplayFormat::decode(uint16_t record, int buffer_rows)
+{
+	int type = record & 7;
+	int rotation = (record >> 3) & 3;
+	int x = ((record >> 5) & 31) - 4;
+	int y = ((record >> 10) & 63) - buffer_rows - 8;
+	return Piece::make(type, x, y, rotation);
+}
+
+ReplayWriter::ReplayWriter(const std::string& path)
+	: file_(std::fopen(path.c_str(), "ab"))
+	, buffer_rows_(0)
+	, failed_(false)
+	, stopping_(false)
+{
+	chunk_.reserve(chunk_size);
+	if (file_ != nullptr)
+	{
+		thread_ = std::thread(&ReplayWriter::write_loop, this);
+	}
+}
+
+ReplayWriter::~ReplayWriter()
+{
+	if (file_ != nullptr)
+	{
+		hand_off();
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stopping_ = true;
+		}
+		wake_.notify_one();
+		thread_.join();
+		std::fclose(file_);
+	}
+}
+
+void ReplayWriter::begin_game(const ReplayHeader& header)
+{
+	if (failed_)
+	{
+		return;
+	}
+	buffer_rows_ = header.buffer_rows;
+	for (char c : magic)
+	{
+		put_u8(static_cast<uint8_t>(c));
+	}
+	put_u8(ReplayFormat::version);
+	put_u8(static_cast<uint8_t>(header.width));
+	put_u8(static_cast<uint8_t>(header.height));
+	put_u8(static_cast<uint8_t>(header.buffer_rows));
+	put_u32(header.seed);
+}
+
+bool ReplayWriter::add_placement(const Piece& piece)
+{
+	uint16_t record;
+	if (failed_ || !ReplayFormat::encode(piece, buffer_rows_, record))
+	{
+		/* what was written so far reads as a game cut short */
+		failed_ = true;
+		return false;
+	}
+	put_u16(record);
+	if (chunk_.size() >= chunk_size)
+	{
+		hand_off();
+	}
+	return true;
+}
+
+void ReplayWriter::end_game()
+{
+	if (failed_)
+	{
+		return;
+	}
+	put_u16(ReplayFormat::game_over);
+	hand_off();
+}
+
+void ReplayWriter::put_u8(uint8_t value)
+{
+	chunk_.push_back(value);
+}
+
+void ReplayWriter::put_u16(uint16_t value)
+{
+	chunk_.push_back(value & 0xff);
+	chunk_.push_back(value >> 8);
+}
+
+void ReplayWriter::put_u32(uint32_t value)
+{
+	put_u16(value & 0xffff);
+	put_u16(value >> 16);
+}
+
+void ReplayWriter::hand_off()
+{
+	if (file_ == nullptr || chunk_.empty())
+	{
+		chunk_.clear();
+		return;
+	}
+
+	std::vector<uint8_t> next;
+	next.reserve(chunk_size);
+	std::swap(next, chunk_);
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		pending_.push_back(std::move(next));
+	}
+	wake_.notify_one();
+}
+
+void ReplayWriter::write_loop()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (true)
+	{
+		wake_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+		if (pending_.empty())
+		{
+			return;
+		}
+
+		std::vector<uint8_t> chunk = std::move(pending_.front());
+		pending_.pop_front();
+		lock.unlock();
+		std::fwrite(chunk.data(), 1, chunk.size(), file_);
+		std::fflush(file_);
+		lock.lock();
+	}
+}
+
+ReplayReader::ReplayReader(const std::string& path)
+	: file_(std::fopen(path.c_str(), "rb"))
+	, buffer_(buffer_size)
+	, position_(0)
+	, end_(0)
+	, in_game_(false)
+	, corrupt_(false)
+{
+}
+
+ReplayReader::~ReplayReader()
+{
+	if (file_ != nullptr)
+	{
+		std::fclose(file_);
+	}
+}
+
+bool ReplayReader::next_game(ReplayHeader& header)
+{
+	Piece skipped;
+	while (in_game_ && next_placement(skipped))
+	{
+	}
+
+	uint8_t bytes[ReplayFormat::header_size];
+	if (corrupt_ || !read(bytes, sizeof(bytes)) || std::memcmp(bytes, magic, sizeof(magic)) != 0 || bytes[4] != ReplayFormat::version)
+	{
+		return false;
+	}
+	if (bytes[5] > PlayField::max_width)
+	{
+		return false;
+	}
+
+	header.width = bytes[5];
+	header.height = bytes[6];
+	header.buffer_rows = bytes[7];
+	header.seed = static_cast<uint32_t>(bytes[8])
+		| (static_cast<uint32_t>(bytes[9]) << 8)
+		| (static_cast<uint32_t>(bytes[10]) << 16)
+		| (static_cast<uint32_t>(bytes[11]) << 24);
+	header_ = header;
+	in_game_ = true;
+	return true;
+}
+
+bool ReplayReader::next_placement(Piece& piece)
+{
+	uint8_t bytes[2];
+	if (!in_game_ || !read(bytes, sizeof(bytes)))
+	{
+		in_game_ = false;
+		return false;
+	}
+
+	uint16_t record = static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+	if (ReplayFormat::is_game_over(record))
+	{
+		in_game_ = false;
+		return false;
+	}
+	piece = ReplayFormat::decode(record, header_.buffer_rows);
+	/* tiles reach 2 columns and rows out from the centre */
+	if (piece.get_x() < -2 || piece.get_x() > header_.width + 1
+		|| piece.get_y() < -header_.buffer_rows - 2 || piece.get_y() > header_.height + 1)
+	{
+		in_game_ = false;
+		corrupt_ = true;
+		return false;
+	}
+	return true;
+}
+
+bool ReplayReader::read(uint8_t* data, size_t size)
+{
+	if (file_ == nullptr)
+	{
+		return false;
+	}
+
+	while (size > 0)
+	{
+		if (position_ == end_)
+		{
+			end_ = std::fread(buffer_.data(), 1, buffer_.size(), file_);
+			position_ = 0;
+			if (end_ == 0)
+			{
+				return false;
+			}
+		}
+		size_t count = std::min(size, end_ - position_);
+		std::memcpy(data, buffer_.data() + position_, count);
+		position_ += count;
+		data += count;
+		size -= count;
+	}
+	return true;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+/*	Compact, append-only recording of played games.
+ *
+ *	A replay file is any number of games back to back. Every game starts with
+ *	a 12 byte header (magic "TSRP", version, board width and height, the
+ *	number of buffer rows and the little-endian 32-bit seed), followed by one 16-bit
+ *	little-endian record per locked piece:
+ *
+ *		bits 0-2	piece type, 7 marks the end of the game
+ *		bits 3-4	rotation
+ *		bits 5-9	x + 4
+ *		bits 10-15	y + buffer rows + 8
+ *
+ *	so y counts from 8 rows above the top buffer row. A game that was cut
+ *	short (ie: the program was closed) simply ends at the end of the file.
+ *	A piece that does not fit in a record, which can happen on fields over 54
+ *	rows tall with their buffer, is not written: the writer stops there, leaving the game
+ *	cut short, and the reader treats such a record as corruption.
+ */
+
+#include "Piece.h"
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ReplayHeader
+{
+	ReplayHeader()
+		: seed(0), width(0), height(0), buffer_rows(0)
+	{}
+
+	ReplayHeader(uint32_t seed_, int width_, int height_, int buffer_rows_ = 0)
+		: seed(seed_), width(width_), height(height_), buffer_rows(buffer_rows_)
+	{}
+
+	uint32_t seed;
+	int width;
+	int height;
+	/* 0 in replays from before there were buffer rows */
+	int buffer_rows;
+};
+
+namespace ReplayFormat
+{
+	const uint8_t version = 1;
+	const int header_size = 12;
+	const uint16_t game_over = 7;
+
+	/* False if the piece is out of the range a record can hold. */
+	bool encode(const Piece& piece, int buffer_rows, uint16_t& record);
+	bool is_game_over(uint16_t record);
+	Piece decode(uint16_t record, int buffer_rows);
+}
+
+/*	Buffers records in memory and leaves the file writes to a background
+	thread, so the game loop never waits for the disk. */
+class ReplayWriter
+{
+public:
+	explicit ReplayWriter(const std::string& path);
+	~ReplayWriter();
+	ReplayWriter(const ReplayWriter&) = delete;
+	ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+	/* False once a placement failed to encode, nothing more is written then. */
+	bool is_open() const { return file_ != nullptr && !failed_; }
+
+	void begin_game(const ReplayHeader& header);
+	/* Returns false if the placement could not be written. */
+	bool add_placement(const Piece& piece);
+	void end_game();
+private:
+	static const size_t chunk_size = 64 * 1024;
+
+	void put_u8(uint8_t value);
+	void put_u16(uint16_t value);
+	void put_u32(uint32_t value);
+	/* passes the current chunk on to the writer thread */
+	void hand_off();
+	void write_loop();
+
+	FILE* file_;
+	std::vector<uint8_t> chunk_;
+	int buffer_rows_;
+	bool failed_;
+
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::deque<std::vector<uint8_t>> pending_;
+	bool stopping_;
+	std::thread thread_;
+};
+
+class ReplayReader
+{
+public:
+	explicit ReplayReader(const std::string& path);
+	~ReplayReader();
+	ReplayReader(const ReplayReader&) = delete;
+	ReplayReader& operator=(const ReplayReader&) = delete;
+
+	bool is_open() const { return file_ != nullptr; }
+
+	/* Moves on to the next game, skipping what is left of the current one.
+		Returns false at the end of the file or if the file is corrupt. */
+	bool next_game(ReplayHeader& header);
+
+	/* Returns false when the current game is over, or at a placement that
+		cannot be on the game's field, after which the file counts as corrupt. */
+	bool next_placement(Piece& piece);
+private:
+	static const size_t buffer_size = 64 * 1024;
+
+	bool read(uint8_t* data, size_t size);
+
+	FILE* file_;
+	std::vector<uint8_t> buffer_;
+	size_t position_;
+	size_t end_;
+	bool in_game_;
+	bool corrupt_;
+	ReplayHeader header_;
+};
@@ -0,0 +1,396 @@
+#include "Server.h"
+
+#ifdef _WIN32
+
+#include <iostream>
+
+int run_server(const std::string& socket_path, int threads)
+{
+	std::cerr << "The solver daemon needs Unix domain sockets, which this build does not support." << std::endl;
+	return 1;
+}
+
+#else
+
+#include "Solver.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+	typedef std::chrono::steady_clock clock;
+
+	enum RequestKind { FindMoveRequest = 1, StatsRequest = 2 };
+	enum Status { Ok = 0, NoPlacement = 1, BadRequest = 2 };
+	const size_t header_size = 12;
+	const uint8_t drop_input = 3;
+	/* the longest queue searched without a time budget, see Server.h */
+	const int max_exhaustive_queue = 3;
+
+	uint16_t read_u16(const uint8_t* data)
+	{
+		return static_cast<uint16_t>(data[0] | (data[1] << 8));
+	}
+
+	uint32_t read_u32(const uint8_t* data)
+	{
+		return read_u16(data) | (static_cast<uint32_t>(read_u16(data + 2)) << 16);
+	}
+
+	void put_u16(std::vector<uint8_t>& out, uint16_t value)
+	{
+		out.push_back(value & 0xff);
+		out.push_back(value >> 8);
+	}
+
+	void put_u32(std::vector<uint8_t>& out, uint32_t value)
+	{
+		put_u16(out, value & 0xffff);
+		put_u16(out, value >> 16);
+	}
+
+	/* Returns the full size of the request at the start of data, or 0 if the header is not in yet. */
+	size_t request_size(const std::vector<uint8_t>& data)
+	{
+		if (data.size() < header_size)
+		{
+			return 0;
+		}
+		if (data[0] != FindMoveRequest)
+		{
+			return header_size;
+		}
+		return header_size + data[2] * sizeof(uint16_t) + data[3];
+	}
+
+	struct Connection
+	{
+		explicit Connection(int fd_)
+			: fd(fd_)
+		{}
+
+		~Connection()
+		{
+			close(fd);
+		}
+
+		/* Responses for the same client can be finished by different workers. */
+		void send_all(const std::vector<uint8_t>& data)
+		{
+			std::lock_guard<std::mutex> lock(write_mutex);
+			size_t sent = 0;
+			while (sent < data.size())
+			{
+				ssize_t count = ::send(fd, data.data() + sent, data.size() - sent, 0);
+				if (count <= 0)
+				{
+					return;
+				}
+				sent += static_cast<size_t>(count);
+			}
+		}
+
+		int fd;
+		std::mutex write_mutex;
+		/* only touched by the network thread */
+		std::vector<uint8_t> input;
+	};
+
+	struct Job
+	{
+		std::shared_ptr<Connection> connection;
+		std::vector<uint8_t> request;
+		clock::time_point received;
+	};
+
+	/* Keeps the most recent latencies to compute percentiles from. */
+	class LatencyStats
+	{
+	public:
+		LatencyStats()
+			: count_(0)
+		{}
+
+		void add(uint32_t microseconds)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			samples_[count_ % samples_.size()] = microseconds;
+			++count_;
+		}
+
+		/* count, p50, p90, p99, max */
+		std::array<uint32_t, 5> summarize()
+		{
+			std::vector<uint32_t> sorted;
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				size_t size = std::min<uint64_t>(count_, samples_.size());
+				sorted.assign(samples_.begin(), samples_.begin() + size);
+			}
+			std::array<uint32_t, 5> summary = { { static_cast<uint32_t>(sorted.size()), 0, 0, 0, 0 } };
+			if (sorted.empty())
+			{
+				return summary;
+			}
+			std::sort(sorted.begin(), sorted.end());
+			summary[1] = sorted[sorted.size() * 50 / 100];
+			summary[2] = sorted[sorted.size() * 90 / 100];
+			summary[3] = sorted[sorted.size() * 99 / 100];
+			summary[4] = sorted.back();
+			return summary;
+		}
+	private:
+		std::mutex mutex_;
+		std::array<uint32_t, 1 << 16> samples_;
+		uint64_t count_;
+	};
+
+	class WorkerPool
+	{
+	public:
+		WorkerPool(int threads, LatencyStats& stats)
+			: stats_(stats)
+		{
+			for (int i = 0; i < threads; ++i)
+			{
+				workers_.emplace_back(&WorkerPool::work, this);
+			}
+		}
+
+		/* Queues a whole batch under one lock and wakes the workers once. */
+		void submit(std::vector<Job>& batch)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				for (auto& job : batch)
+				{
+					jobs_.push_back(std::move(job));
+				}
+			}
+			batch.clear();
+			wake_.notify_all();
+		}
+	private:
+		void work()
+		{
+			Solver solver;
+			while (true)
+			{
+				Job job;
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					wake_.wait(lock, [this]() { return !jobs_.empty(); });
+					job = std::move(jobs_.front());
+					jobs_.pop_front();
+				}
+
+				job.connection->send_all(handle(solver, job.request));
+				auto latency = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - job.received);
+				stats_.add(static_cast<uint32_t>(latency.count()));
+			}
+		}
+
+		std::vector<uint8_t> handle(Solver& solver, const std::vector<uint8_t>& request)
+		{
+			std::vector<uint8_t> response;
+			put_u32(response, read_u32(&request[4]));
+
+			if (request[0] == StatsRequest)
+			{
+				response.push_back(Ok);
+				response.insert(response.end(), 3, 0);
+				for (uint32_t value : stats_.summarize())
+				{
+					put_u32(response, value);
+				}
+				return response;
+			}
+
+			int width = request[1];
+			int height = request[2];
+			int queue_length = request[3];
+			int time_budget_ms = read_u16(&request[8]);
+			const uint8_t* rows = &request[header_size];
+			const uint8_t* queue = rows + height * sizeof(uint16_t);
+
+			bool valid = request[0] == FindMoveRequest && width >= 4 && width <= 16
+				&& height >= 4 && height <= PlacementGenerator::max_rows && queue_length > 0
+				&& (time_budget_ms > 0 || queue_length <= max_exhaustive_queue);
+			for (int i = 0; valid && i < queue_length; ++i)
+			{
+				valid = queue[i] < Piece::type_count;
+			}
+			if (!valid)
+			{
+				response.push_back(BadRequest);
+				response.insert(response.end(), 11, 0);
+				return response;
+			}
+
+			PlayField play_field(width, height);
+			for (int y = 0; y < height; ++y)
+			{
+				uint16_t row = read_u16(rows + y * sizeof(uint16_t));
+				for (int x = 0; x < width; ++x)
+				{
+					play_field.set(x, y, ((row >> x) & 1) != 0);
+				}
+			}
+			std::vector<Piece> pieces;
+			for (int i = 0; i < queue_length; ++i)
+			{
+				pieces.push_back(Piece::make(queue[i], width / 2, 0, 0));
+			}
+
+			Solver::Move move = solver.find_move(play_field, pieces, time_budget_ms);
+			std::vector<uint8_t> inputs;
+			for (auto& frame : move.recording)
+			{
+				for (auto action : frame)
+				{
+					inputs.push_back(static_cast<uint8_t>(action));
+				}
+				inputs.push_back(drop_input);
+			}
+
+			if (move.found)
+			{
+				response.push_back(Ok);
+				response.push_back(static_cast<uint8_t>(move.placement.get_type()));
+				response.push_back(static_cast<uint8_t>(static_cast<int8_t>(move.placement.get_x())));
+				response.push_back(static_cast<uint8_t>(static_cast<int8_t>(move.placement.get_y())));
+				response.push_back(static_cast<uint8_t>(move.placement.get_rotation()));
+			}
+			else
+			{
+				response.push_back(NoPlacement);
+				response.insert(response.end(), 4, 0);
+			}
+			response.push_back(static_cast<uint8_t>(move.depth));
+			put_u16(response, static_cast<uint16_t>(inputs.size()));
+			put_u32(response, static_cast<uint32_t>(move.nodes));
+			response.insert(response.end(), inputs.begin(), inputs.end());
+			return response;
+		}
+
+		LatencyStats& stats_;
+		std::mutex mutex_;
+		std::condition_variable wake_;
+		std::deque<Job> jobs_;
+		std::vector<std::thread> workers_;
+	};
+}
+
+int run_server(const std::string& socket_path, int threads)
+{
+	if (threads <= 0)
+	{
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socket_path.size() >= sizeof(address.sun_path))
+	{
+		std::cerr << "Socket path is too long: " << socket_path << std::endl;
+		return 1;
+	}
+	std::strcpy(address.sun_path, socket_path.c_str());
+
+	/* a client hanging up while its response is sent must not kill the daemon */
+	std::signal(SIGPIPE, SIG_IGN);
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(socket_path.c_str());
+	if (listener == -1 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1 || listen(listener, 64) == -1)
+	{
+		std::cerr << "Could not listen on " << socket_path << ": " << std::strerror(errno) << std::endl;
+		return 1;
+	}
+	std::cout << "listening on " << socket_path << " with " << threads << " workers" << std::endl;
+
+	LatencyStats stats;
+	WorkerPool pool(threads, stats);
+	std::vector<std::shared_ptr<Connection>> connections;
+	std::vector<pollfd> fds;
+	std::vector<Job> batch;
+	uint8_t buffer[64 * 1024];
+
+	while (true)
+	{
+		fds.clear();
+		fds.push_back({ listener, POLLIN, 0 });
+		for (auto& connection : connections)
+		{
+			fds.push_back({ connection->fd, POLLIN, 0 });
+		}
+		if (poll(fds.data(), fds.size(), -1) == -1)
+		{
+			continue;
+		}
+
+		/* everything that arrived during this wake-up goes to the workers as one batch */
+		auto now = clock::now();
+		for (size_t i = fds.size() - 1; i >= 1; --i)
+		{
+			if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) == 0)
+			{
+				continue;
+			}
+
+			auto& connection = connections[i - 1];
+			ssize_t count = recv(connection->fd, buffer, sizeof(buffer), 0);
+			if (count <= 0)
+			{
+				connections.erase(connections.begin() + (i - 1));
+				continue;
+			}
+
+			auto& input = connection->input;
+			input.insert(input.end(), buffer, buffer + count);
+			size_t size;
+			while ((size = request_size(input)) != 0 && input.size() >= size)
+			{
+				Job job;
+				job.connection = connection;
+				job.request.assign(input.begin(), input.begin() + size);
+				job.received = now;
+				batch.push_back(std::move(job));
+				input.erase(input.begin(), input.begin() + size);
+			}
+		}
+		if (!batch.empty())
+		{
+			pool.submit(batch);
+		}
+
+		if (fds[0].revents & POLLIN)
+		{
+			int client = accept(listener, nullptr, nullptr);
+			if (client != -1)
+			{
+				connections.push_back(std::make_shared<Connection>(client));
+			}
+		}
+	}
+	return 0;
+}
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+
+/*	Runs the solver as a daemon on a Unix domain socket.
+ *
+ *	Clients send binary requests and get binary responses back, all numbers
+ *	little-endian. A request starts with a 12 byte header:
+ *
+ *		uint8_t kind			1 = find a move, 2 = latency statistics
+ *		uint8_t width
+ *		uint8_t height
+ *		uint8_t queue_length
+ *		uint32_t request_id		echoed in the response
+ *		uint16_t time_budget_ms	0 searches the whole queue
+ *		uint16_t				spare
+ *
+ *	Without a time budget the search takes time exponential in the queue
+ *	length and cannot be cut short, so such requests may queue at most 3
+ *	pieces, longer ones are answered as bad requests.
+ *
+ *	Widths go from 4 to 16 and heights from 4 to 64, anything else is a bad
+ *	request. A move request continues with uint16_t rows[height] (bit x of a
+ *	row is set if the tile is occupied, row 0 is the top) and uint8_t
+ *	queue[queue_length], the piece types from Piece::get_type. Statistics
+ *	requests have no body and leave the other header fields at 0.
+ *
+ *	A move response is:
+ *
+ *		uint32_t request_id
+ *		uint8_t status			0 = ok, 1 = no placement, 2 = bad request
+ *		uint8_t type, int8_t x, int8_t y, uint8_t rotation
+ *		uint8_t depth			queue pieces the search finished
+ *		uint16_t input_count
+ *		uint32_t nodes
+ *		uint8_t inputs[input_count]	0 = rotate, 1 = left, 2 = right, 3 = drop
+ *
+ *	A statistics response is the request_id, a status byte, 3 spare bytes
+ *	and five uint32_t: the number of requests measured and the 50th, 90th
+ *	and 99th percentile and maximum latency in microseconds.
+ *
+ *	Requests from all clients are collected in batches and spread over a
+ *	pool of worker threads, each with its own Solver.
+ */
+
+#include <string>
+
+/* Returns the process exit code. Runs until the process is killed. */
+int run_server(const std::string& socket_path, int threads);
@@ -0,0 +1,326 @@
+#include "TextProtocol.h"
+#include "Engine.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const std::string piece_names = "OISZLJT";
+	const int default_width = 10;
+	const int default_height = 20;
+
+	class ProtocolSession
+	{
+	public:
+		explicit ProtocolSession(std::ostream& output)
+			: output_(output)
+			, play_field_(default_width, default_height)
+			, buffer_rows_(0)
+			, time_budget_ms_(0)
+			, beam_width_(0)
+			, beam_depth_(0)
+			, searching_(false)
+			, stop_(false)
+		{}
+
+		~ProtocolSession()
+		{
+			stop_search();
+		}
+
+		/* Returns false once the session should end. */
+		bool handle(const std::string& line)
+		{
+			std::istringstream words(line);
+			std::string command;
+			if (!(words >> command))
+			{
+				return true;
+			}
+
+			if (command == "tsi")
+			{
+				send("id name TetrisSolver\ntsiok");
+			}
+			else if (command == "isready")
+			{
+				send("readyok");
+			}
+			else if (command == "board")
+			{
+				set_board(words);
+			}
+			else if (command == "buffer")
+			{
+				int buffer_rows = 0;
+				words >> buffer_rows;
+				if (buffer_rows + 4 > PlacementGenerator::max_rows)
+				{
+					send("info string bad buffer size");
+				}
+				else
+				{
+					buffer_rows_ = std::max(buffer_rows, 0);
+				}
+			}
+			else if (command == "queue" || command == "push")
+			{
+				std::string pieces;
+				words >> pieces;
+				std::lock_guard<std::mutex> lock(state_mutex_);
+				if (command == "queue")
+				{
+					queue_.clear();
+				}
+				for (char name : pieces)
+				{
+					size_t type = piece_names.find(static_cast<char>(std::toupper(name)));
+					if (type == std::string::npos)
+					{
+						send("info string unknown piece " + std::string(1, name));
+						continue;
+					}
+					queue_.push_back(static_cast<int>(type));
+				}
+			}
+			else if (command == "budget")
+			{
+				words >> time_budget_ms_;
+			}
+			else if (command == "beam")
+			{
+				beam_depth_ = 0;
+				words >> beam_width_ >> beam_depth_;
+			}
+			else if (command == "mcts")
+			{
+				set_mcts(words);
+			}
+			else if (command == "go")
+			{
+				go();
+			}
+			else if (command == "stop")
+			{
+				stop_search();
+			}
+			else if (command == "play")
+			{
+				play();
+			}
+			else if (command == "quit")
+			{
+				return false;
+			}
+			else
+			{
+				send("info string unknown command " + command);
+			}
+			return true;
+		}
+	private:
+		void send(const std::string& text)
+		{
+			std::lock_guard<std::mutex> lock(output_mutex_);
+			output_ << text << std::endl;
+		}
+
+		void set_board(std::istringstream& words)
+		{
+			int width = default_width;
+			int height = default_height;
+			words >> width >> height;
+			if (width < 4 || width > PlayField::max_width || height < 4 || height + buffer_rows_ > PlacementGenerator::max_rows)
+			{
+				send("info string bad board size");
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock(state_mutex_);
+			play_field_ = PlayField(width, height, buffer_rows_);
+			std::string row;
+			for (int y = 0; y < height && words >> row; ++y)
+			{
+				for (int x = 0; x < width && x < static_cast<int>(row.size()); ++x)
+				{
+					play_field_.set(x, y, row[x] != '.');
+				}
+			}
+		}
+
+		void go()
+		{
+			if (searching_)
+			{
+				send("info string already searching");
+				return;
+			}
+
+			PlayField play_field(0, 0);
+			std::vector<Piece> pieces;
+			{
+				std::lock_guard<std::mutex> lock(state_mutex_);
+				play_field = play_field_;
+				for (int type : queue_)
+				{
+					pieces.push_back(Piece::make(type, play_field.get_width() / 2, play_field.get_spawn_y(), 0));
+				}
+			}
+			if (pieces.empty())
+			{
+				send("info string the queue is empty");
+				return;
+			}
+
+			if (search_thread_.joinable())
+			{
+				search_thread_.join();
+			}
+			stop_ = false;
+			searching_ = true;
+			SearchOptions options;
+			options.time_budget_ms = time_budget_ms_;
+			options.stop = &stop_;
+			options.beam_width = beam_width_;
+			options.beam.depth = beam_depth_;
+			search_thread_ = std::thread([this, play_field, pieces, options]()
+			{
+				auto start = std::chrono::steady_clock::now();
+				Solver::Move move = mcts_ ? mcts_->find_move(play_field, pieces, options.time_budget_ms, options.stop) : best_move(play_field, pieces, options);
+				std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+				{
+					/* done before reporting, so a "play" right after the answer sees it */
+					std::lock_guard<std::mutex> lock(state_mutex_);
+					best_move_ = move;
+					searching_ = false;
+				}
+				report(move, elapsed.count());
+			});
+		}
+
+		void report(const Solver::Move& move, double seconds)
+		{
+			std::ostringstream text;
+			text << "info depth " << move.depth
+				<< " nodes " << move.nodes
+				<< " duplicates " << move.duplicates
+				<< " time " << static_cast<long long>(seconds * 1000.0)
+				<< " nps " << static_cast<long long>(move.nodes / std::max(seconds, 1e-6)) << "\n";
+			if (!move.found)
+			{
+				text << "bestmove none";
+				send(text.str());
+				return;
+			}
+
+			const Piece& piece = move.placement;
+			text << "bestmove " << piece_names[piece.get_type()]
+				<< " " << piece.get_x()
+				<< " " << piece.get_y()
+				<< " " << piece.get_rotation() << " ";
+			for (auto& frame : move.recording)
+			{
+				for (auto action : frame)
+				{
+					text << (action == Action::Rotate ? 'u' : action == Action::Left ? 'l' : 'r');
+				}
+				text << 'd';
+			}
+			send(text.str());
+		}
+
+		void set_mcts(std::istringstream& words)
+		{
+			if (searching_)
+			{
+				send("info string cannot change the search while searching");
+				return;
+			}
+			std::string simulations;
+			words >> simulations;
+			if (simulations == "off")
+			{
+				mcts_.reset();
+				return;
+			}
+			MctsOptions options;
+			options.simulations = std::atoi(simulations.c_str());
+			mcts_.reset(new MctsSearch(options));
+		}
+
+		void stop_search()
+		{
+			stop_ = true;
+			if (search_thread_.joinable())
+			{
+				search_thread_.join();
+			}
+		}
+
+		void play()
+		{
+			if (searching_)
+			{
+				send("info string cannot play while searching");
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock(state_mutex_);
+			if (!best_move_.found || queue_.empty())
+			{
+				send("info string no move to play");
+				return;
+			}
+			play_field_.imprint(best_move_.placement);
+			queue_.erase(queue_.begin());
+			best_move_ = Solver::Move();
+		}
+
+		std::ostream& output_;
+		std::mutex output_mutex_;
+
+		/* the position, shared with the search thread once it is done */
+		std::mutex state_mutex_;
+		PlayField play_field_;
+		int buffer_rows_;
+		std::vector<int> queue_;
+		Solver::Move best_move_;
+		int time_budget_ms_;
+		int beam_width_;
+		int beam_depth_;
+		/* set while "mcts" is on, kept so the tree carries over between moves */
+		std::unique_ptr<MctsSearch> mcts_;
+
+		std::thread search_thread_;
+		std::atomic<bool> searching_;
+		std::atomic<bool> stop_;
+	};
+}
+
+int run_text_protocol(std::istream& input, std::ostream& output)
+{
+	ProtocolSession session(output);
+	std::string line;
+	while (std::getline(input, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+		if (!session.handle(line))
+		{
+			break;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+/*	A line based text protocol on stdin/stdout, in the spirit of UCI for chess
+ *	engines, so that match harnesses can drive the solver. Commands:
+ *
+ *		tsi						answered with "id name ..." and "tsiok"
+ *		isready					answered with "readyok", also during a search
+ *		board <w> <h> [rows]	sets an empty board, then fills it from the
+ *								given rows, top first. '.' is an empty tile,
+ *								any other character an occupied one. The
+ *								height and buffer may add up to 64 rows
+ *		buffer <rows>			hidden rows above the visible ones for the
+ *								boards set from now on, pieces then spawn in them,
+ *								at most 60
+ *		queue <pieces>			replaces the piece queue, e.g. "queue TIZ"
+ *		push <pieces>			appends to the piece queue
+ *		budget <ms>				time budget of a search, 0 searches the whole queue
+ *		beam <width> [depth]	searches with a beam of that width instead,
+ *								0 goes back to the full search
+ *		mcts <simulations>|off	searches with Monte Carlo tree search, which
+ *								keeps its tree from one move to the next.
+ *								0 simulations leaves the length to the budget
+ *		go						searches for a move on a worker thread
+ *		stop					ends the running search early
+ *		play					locks the last best move on the board and
+ *								takes its piece off the queue
+ *		quit
+ *
+ *	Commands keep being read while a search runs, so the next piece can be
+ *	pushed as soon as it is known. The search works on the board and queue
+ *	as they were at "go", changes are picked up by the next one. A finished
+ *	search prints
+ *
+ *		info depth <d> nodes <n> duplicates <n> time <ms> nps <n>
+ *		bestmove <piece> <x> <y> <rotation> <inputs>
+ *
+ *	where duplicates counts placements that left a board the search had
+ *	already looked at, and inputs has a character per input: u rotates, l
+ *	and r move left and right and d ends a row. "bestmove none" means no
+ *	placement was found.
+ */
+
+#include <iosfwd>
+
+/* Returns the process exit code once "quit" was read or input ends. */
+int run_text_protocol(std::istream& input, std::ostream& output);
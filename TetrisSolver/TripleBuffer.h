@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+/*	Hands values from one writer thread to one reader thread without locks.
+ *	The writer fills write_buffer() and publishes it, the reader calls update()
+ *	and reads read_buffer(). Neither side ever waits for the other, the reader
+ *	simply keeps the last value it got until a newer one is published.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer()
+		: write_(0)
+		, read_(1)
+		, middle_(2)
+	{}
+
+	T& write_buffer()
+	{
+		return slots_[write_].value;
+	}
+
+	/* Makes the write buffer visible to the reader and starts on a free one. */
+	void publish()
+	{
+		write_ = middle_.exchange(write_ | fresh_bit, std::memory_order_acq_rel) & index_mask;
+	}
+
+	/* Returns true if a value newer than the current read buffer was taken. */
+	bool update()
+	{
+		if ((middle_.load(std::memory_order_relaxed) & fresh_bit) == 0)
+		{
+			return false;
+		}
+		read_ = middle_.exchange(read_, std::memory_order_acq_rel) & index_mask;
+		return true;
+	}
+
+	const T& read_buffer() const
+	{
+		return slots_[read_].value;
+	}
+private:
+	static const int index_mask = 3;
+	static const int fresh_bit = 4;
+
+	/* keeps the writer and the reader off each other's cache lines */
+	struct alignas(64) Slot
+	{
+		T value;
+	};
+
+	std::array<Slot, 3> slots_;
+	int write_;
+	int read_;
+	std::atomic<int> middle_;
+};
@@ -1,59 +1,303 @@
+#ifndef TETRIS_NO_GUI
 #include <SDL.h>
 #include "Window.h"
+#endif
 #include "Board.h"
 #include "Timer.h"
-#include "Solver.h"
+#include "AutoPlayer.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "FixedTimestep.h"
+#include "TripleBuffer.h"
+#include "Replay.h"
+#include "Headless.h"
+#include "Server.h"
+#include "TextProtocol.h"
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
 
+struct Options
+{
+	Options()
+		: tick_rate(60.0)
+		, render_rate(60.0)
+		, max_catch_up(8)
+		, uncapped(false)
+		, has_seed(false)
+		, seed(0)
+		, games(10)
+		, max_pieces(1000)
+		, threads(0)
+		, text_protocol(false)
+	{}
+
+	double tick_rate;
+	double render_rate;
+	int max_catch_up;
+	bool uncapped;
+	bool has_seed;
+	unsigned int seed;
+	std::string record_path;
+	std::string replay_path;
+	std::string generate_dataset_path;
+	std::string evaluate_dataset_path;
+	std::string socket_path;
+	int games;
+	int max_pieces;
+	int threads;
+	bool text_protocol;
+};
+
+Options parse_options(int argc, char *argv[]);
+#ifndef TETRIS_NO_GUI
 int handle_input(Board&, Window&);
+#endif
 
 int main(int argc, char *argv[])
 {
+	Options options = parse_options(argc, argv);
+	if (!options.replay_path.empty())
+	{
+		return run_replay(options.replay_path);
+	}
+	if (!options.generate_dataset_path.empty())
+	{
+		return run_generate_dataset(options.generate_dataset_path, options.seed, options.games, options.max_pieces);
+	}
+	if (!options.evaluate_dataset_path.empty())
+	{
+		return run_evaluate_dataset(options.evaluate_dataset_path, options.threads);
+	}
+	if (!options.socket_path.empty())
+	{
+		return run_server(options.socket_path, options.threads);
+	}
+	if (options.text_protocol)
+	{
+		return run_text_protocol(std::cin, std::cout);
+	}
+
+#ifdef TETRIS_NO_GUI
+	std::cerr << "This build has no window, pick one of the headless modes." << std::endl;
+	return 1;
+#else
 	Window win("Tetris!", 800, 600);
 	win.MapKey(SDLK_UP, "up");
 	win.MapKey(SDLK_DOWN, "down");
 	win.MapKey(SDLK_LEFT, "left");
 	win.MapKey(SDLK_RIGHT, "right");
-	Board board(0, 0, 16);
-	Solver solver;
+	win.MapKey(SDLK_SPACE, "space");
+	Board board = options.has_seed ? Board(0, 0, 16, options.seed) : Board(0, 0, 16);
+	AutoPlayer player;
 
-	float rot = 0.0f;
+	std::unique_ptr<ReplayWriter> replay;
+	if (!options.record_path.empty())
+	{
+		replay.reset(new ReplayWriter(options.record_path));
+		if (!replay->is_open())
+		{
+			std::cerr << "Could not open replay for writing: " << options.record_path << std::endl;
+			replay.reset();
+		}
+	}
+	if (replay)
+	{
+		replay->begin_game(ReplayHeader(board.get_seed(), board.get_width(), board.get_height(), board.get_buffer_rows()));
+		board.set_lock_listener([&replay](const Piece& piece)
+		{
+			if (replay->is_open() && !replay->add_placement(piece))
+			{
+				std::cerr << "Stopped recording, a placement is out of the replay format's range" << std::endl;
+			}
+		});
+	}
 
-	Timer timer;
-	timer.Start();
-	int tick_time = 1000;
+#ifdef TETRIS_TRACE
+	Trace::set_thread_name("render");
+	Trace::enable_markers();
+#endif
 
-	while (win.Open())
+	/*	The simulation runs on its own thread at a fixed tick rate and
+		publishes a snapshot of the board after every batch of ticks. The
+		renderer draws whichever snapshot is the latest, neither side waits
+		for the other. */
+	std::atomic<bool> running(true);
+	std::atomic<int> tick_count(0);
+	TripleBuffer<Board::Snapshot> snapshots;
+	board.make_snapshot(snapshots.write_buffer());
+	snapshots.publish();
+
+	std::thread simulation([&]()
 	{
-		win.PollEvents();
-		
-		/*
-		tick_time = handle_input(board, win);
-		
-		if (timer.ElapsedMilliseconds() > tick_time)
+#ifdef TETRIS_TRACE
+		Trace::set_thread_name("simulation");
+#endif
+		FixedTimestep timestep(options.tick_rate, options.max_catch_up);
+		timestep.set_uncapped(options.uncapped);
+		bool game_over = false;
+		while (running)
 		{
-			int tick = board.tick();
+			int ticks = timestep.ticks_due();
+			for (int i = 0; i < ticks; ++i)
+			{
+				TRACE_SCOPE("AutoPlayer::update");
+				player.update(board);
+			}
+			tick_count += ticks;
+
+			if (replay && board.is_game_over() && !game_over)
+			{
+				replay->end_game();
+			}
+			game_over = board.is_game_over();
 
-			if (tick == -1)
+			if (ticks > 0)
 			{
-				win.Exit();
+				TRACE_SCOPE("publish snapshot");
+				board.make_snapshot(snapshots.write_buffer());
+				snapshots.publish();
 			}
-			timer.Start();
-		}*/
-		solver.update(board);
-		board.render(win);
+			timestep.wait();
+		}
+	});
+
+	FixedTimestep frame_pacer(options.render_rate, 1);
+	Timer report_timer;
+	report_timer.Start();
+	int frame_count = 0;
+
+	while (win.Open())
+	{
+		TRACE_SCOPE("frame");
+
+		TRACE_BEGIN("Window::PollEvents");
+		win.PollEvents();
+		TRACE_END("Window::PollEvents");
+
+		snapshots.update();
+
+		TRACE_BEGIN("Board::render");
+		board.render(snapshots.read_buffer(), win);
+		TRACE_END("Board::render");
 
+		TRACE_BEGIN("Window::Display");
 		win.Display();
+		TRACE_END("Window::Display");
+
+		++frame_count;
+		int elapsed = report_timer.ElapsedMilliseconds();
+		if (elapsed >= 1000)
+		{
+			std::cout << "simulation: " << tick_count.exchange(0) * 1000.0 / elapsed << " ticks/s, "
+				<< "render: " << frame_count * 1000.0 / elapsed << " frames/s" << std::endl;
+			frame_count = 0;
+			report_timer.Start();
+		}
+
+		frame_pacer.ticks_due();
+		frame_pacer.wait();
 	}
+
+	running = false;
+	simulation.join();
+
+#ifdef TETRIS_PROFILE
+	std::ofstream profile_csv("solver_profile.csv");
+	Profiler::get().write_csv(profile_csv);
+	std::ofstream profile_json("solver_profile.json");
+	Profiler::get().write_json(profile_json);
+#endif
+#ifdef TETRIS_TRACE
+	Trace::write_chrome_json("trace.json");
+#endif
 	return 0;
+#endif
 }
 
+Options parse_options(int argc, char *argv[])
+{
+	Options options;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--tick-rate" && i + 1 < argc)
+		{
+			options.tick_rate = std::atof(argv[++i]);
+		}
+		else if (arg == "--render-rate" && i + 1 < argc)
+		{
+			options.render_rate = std::atof(argv[++i]);
+		}
+		else if (arg == "--max-catch-up" && i + 1 < argc)
+		{
+			options.max_catch_up = std::atoi(argv[++i]);
+		}
+		else if (arg == "--uncapped")
+		{
+			options.uncapped = true;
+		}
+		else if (arg == "--seed" && i + 1 < argc)
+		{
+			options.has_seed = true;
+			options.seed = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--record" && i + 1 < argc)
+		{
+			options.record_path = argv[++i];
+		}
+		else if (arg == "--replay" && i + 1 < argc)
+		{
+			options.replay_path = argv[++i];
+		}
+		else if (arg == "--generate-dataset" && i + 1 < argc)
+		{
+			options.generate_dataset_path = argv[++i];
+		}
+		else if (arg == "--evaluate-dataset" && i + 1 < argc)
+		{
+			options.evaluate_dataset_path = argv[++i];
+		}
+		else if (arg == "--serve" && i + 1 < argc)
+		{
+			options.socket_path = argv[++i];
+		}
+		else if (arg == "--engine")
+		{
+			options.text_protocol = true;
+		}
+		else if (arg == "--games" && i + 1 < argc)
+		{
+			options.games = std::atoi(argv[++i]);
+		}
+		else if (arg == "--pieces" && i + 1 < argc)
+		{
+			options.max_pieces = std::atoi(argv[++i]);
+		}
+		else if (arg == "--threads" && i + 1 < argc)
+		{
+			options.threads = std::atoi(argv[++i]);
+		}
+		else
+		{
+			std::cerr << "Unknown option: " << arg << std::endl;
+		}
+	}
+	return options;
+}
+
+#ifndef TETRIS_NO_GUI
 int handle_input(Board& board, Window& win)
 {
 	int tick_time;
 
 	if (win.GetKey("up").pressed)
 	{
-		board.perform_action(Board::Rotate);
+		board.perform_action(Action::Rotate);
 	}
 
 	if (win.GetKey("down").down)
@@ -67,11 +311,16 @@ int handle_input(Board& board, Window& win)
 
 	if (win.GetKey("left").pressed)
 	{
-		board.perform_action(Board::Left);
+		board.perform_action(Action::Left);
 	}
 	if (win.GetKey("right").pressed)
 	{
-		board.perform_action(Board::Right);
+		board.perform_action(Action::Right);
+	}
+	if (win.GetKey("space").pressed)
+	{
+		board.hard_drop();
 	}
 	return tick_time;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file